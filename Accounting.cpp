@@ -0,0 +1,116 @@
+#include "Accounting.h"
+#include <cstdlib>
+#include <ctime>
+#include <new>
+#include <atomic>
+
+using namespace std;
+
+// Every allocation carries a header recording its size and
+// the account it was charged to, so counts stay exact through delete
+namespace
+{
+    const size_t HEADER = alignof(max_align_t) < 2 * sizeof(void*) ? 2 * sizeof(void*) : alignof(max_align_t);
+    atomic<size_t> liveBytes(0);
+    thread_local HeapUsage* t_charge = nullptr;
+
+    struct BlockHeader
+    {
+        size_t size;
+        HeapUsage* owner;
+    };
+
+#ifndef NO_HEAP_ACCOUNTING
+    void* allocate(size_t size) noexcept
+    {
+        char* block = static_cast<char*>(malloc(size + HEADER));
+        if (block == nullptr)
+            return nullptr;
+        BlockHeader* header = reinterpret_cast<BlockHeader*>(block);
+        header->size = size;
+        header->owner = t_charge;
+        liveBytes.fetch_add(size, memory_order_relaxed);
+
+        HeapUsage* usage = t_charge;
+        if (usage != nullptr)
+        {
+            usage->allocs++;
+            usage->bytes += size;
+            usage->liveBytes += size;
+            if (usage->liveBytes > usage->peakBytes)
+                usage->peakBytes = usage->liveBytes;
+        }
+        return block + HEADER;
+    }
+#endif
+}
+
+HeapCharge::HeapCharge(HeapUsage* usage) : m_previous(t_charge)
+{
+    t_charge = usage;
+}
+
+HeapCharge::~HeapCharge()
+{
+    t_charge = m_previous;
+}
+
+size_t heapLiveBytes()
+{
+    return liveBytes;
+}
+
+double threadCpuMs()
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+#else
+    // Process time where per-thread time is unavailable
+    return 1000.0 * clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+// Build with -DNO_HEAP_ACCOUNTING to keep the standard allocator,
+// as a shared library loaded into another program must
+#ifndef NO_HEAP_ACCOUNTING
+
+void* operator new(size_t size)
+{
+    void* p = allocate(size);
+    if (p == nullptr)
+        throw bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+// A free only counts against an account while that account
+// is being charged; the owner pointer is compared, never followed
+void operator delete(void* p) noexcept
+{
+    if (p == nullptr)
+        return;
+    char* block = static_cast<char*>(p) - HEADER;
+    BlockHeader* header = reinterpret_cast<BlockHeader*>(block);
+    liveBytes.fetch_sub(header->size, memory_order_relaxed);
+    if (header->owner != nullptr && header->owner == t_charge)
+        t_charge->liveBytes -= header->size;
+    free(block);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete(void* p, const nothrow_t&) noexcept
+{
+    operator delete(p);
+}
+
+#endif // NO_HEAP_ACCOUNTING
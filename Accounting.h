@@ -0,0 +1,38 @@
+#ifndef ACCOUNTING_INCLUDED
+#define ACCOUNTING_INCLUDED
+
+#include <cstddef>
+
+  // Heap traffic charged to one account (normally one player's clock)
+  //
+  // Counting replaces the global operator new; build with
+  // -DNO_HEAP_ACCOUNTING to leave it alone, and every count stays 0
+struct HeapUsage
+{
+    long long allocs;      // calls to operator new
+    long long bytes;       // bytes requested
+    long long liveBytes;   // allocated and not yet freed under this account
+    long long peakBytes;   // highest liveBytes seen
+};
+
+  // While alive, allocations on this thread are charged to usage;
+  // the previous account is restored on destruction
+class HeapCharge
+{
+  public:
+    explicit HeapCharge(HeapUsage* usage);
+    ~HeapCharge();
+    HeapCharge(const HeapCharge&) = delete;
+    HeapCharge& operator=(const HeapCharge&) = delete;
+
+  private:
+    HeapUsage* m_previous;
+};
+
+  // Bytes currently allocated through global operator new
+std::size_t heapLiveBytes();
+
+  // CPU time used by the calling thread, in ms
+double threadCpuMs();
+
+#endif // ACCOUNTING_INCLUDED
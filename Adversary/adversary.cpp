@@ -0,0 +1,405 @@
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -pthread Adversary/adversary.cpp Accounting.cpp Board.cpp Capture.cpp Game.cpp GameRecord.cpp Histogram.cpp OpponentModel.cpp Player.cpp ResultStore.cpp Shard.cpp Sprt.cpp Tournament.cpp Trace.cpp utility.cpp
+//
+// Usage:
+//   adversary strategy [--objective shots|time] [--steps n] [--chains n] [--games n]
+//             [--top n] [--threads n] [--seed s] [--out corpus.bsgr]
+//
+// Searches for standard-fleet 10x10 boards the strategy does worst on:
+// the most shots to sink the fleet, or with --objective time the most
+// compute per move. Each chain anneals one fleet, moving, turning or
+// relocating a ship at every step and scoring the result by having the
+// strategy attack it in --games simulated games (seeded, so a board
+// scores the same every time for all but the clock). Chains run in
+// parallel, one at a time per thread.
+//
+// The --top hardest distinct boards (default 20) are appended to the
+// corpus, a game-record file, so several searches can build one. Each
+// board is one record in which the strategy (moving first) sinks the
+// hard fleet (the second player's) as in the first of its scoring
+// games, while the fleet's owner passes every turn by firing off the
+// board. Replay re-fights them with another strategy,
+//   replay corpus.bsgr good
+// and the benchmark times strategies on them with --corpus corpus.bsgr.
+// Deterministic strategies such as good need only --games 1, the default.
+
+#include "../Game.h"
+#include "../Player.h"
+#include "../Board.h"
+#include "../globals.h"
+#include "../utility.h"
+#include "../GameRecord.h"
+#include "../Tournament.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+typedef vector<GameRecord::Placement> Layout;  // a fleet's placements, in shipId order
+
+enum Objective {
+    SHOTS, TIME
+};
+
+struct Score
+{
+    double shots;      // mean shots to sink the fleet
+    double usPerMove;  // mean recommendAttack time
+    double value;      // the objective's measure; higher is harder
+};
+
+struct Candidate
+{
+    Layout fleet;
+    Score score;
+};
+
+struct SearchConfig
+{
+    string strategy;
+    Objective objective = SHOTS;
+    int steps = 2000;
+    int nChains = 0;   // 0 means one per thread
+    int nGames = 1;
+    int nTop = 20;
+    unsigned seed = 1;
+};
+
+//######################
+// Marks the cells of one ship in used, or returns
+// false if it runs off the board or overlaps
+//######################
+bool occupy(const Game& g, const GameRecord::Placement& pl, int length, Bitboard& used)
+{
+    int dr = pl.dir == VERTICAL ? 1 : 0;
+    int dc = 1 - dr;
+    for (int i = 0; i < length; i++)
+    {
+        Point p(pl.topOrLeft.r + dr * i, pl.topOrLeft.c + dc * i);
+        if (!g.isValid(p) || used.test(cellIndex(p)))
+            return false;
+        used.set(cellIndex(p));
+    }
+    return true;
+}
+
+bool validFleet(const Game& g, const Layout& fleet)
+{
+    Bitboard used;
+    for (int shipId = 0; shipId < g.nShips(); shipId++)
+        if (!occupy(g, fleet[shipId], g.shipLength(shipId), used))
+            return false;
+    return true;
+}
+
+GameRecord::Placement randomPlacement(const Game& g, mt19937& rng)
+{
+    GameRecord::Placement pl;
+    pl.dir = rng() % 2 == 0 ? VERTICAL : HORIZONTAL;
+    pl.topOrLeft = Point(rng() % g.rows(), rng() % g.cols());
+    return pl;
+}
+
+//######################
+// A uniformly placed fleet, one ship at a time
+//######################
+Layout randomFleet(const Game& g, mt19937& rng)
+{
+    Layout fleet(g.nShips());
+    for (;;)
+    {
+        Bitboard used;
+        int shipId = 0;
+        for ( ; shipId < g.nShips(); shipId++)
+        {
+            int tries = 0;
+            do
+                fleet[shipId] = randomPlacement(g, rng);
+            while (++tries < 100 && !occupy(g, fleet[shipId], g.shipLength(shipId), used));
+            if (tries == 100)
+                break;
+        }
+        if (shipId == g.nShips())
+            return fleet;
+    }
+}
+
+//######################
+// A neighbouring fleet: one ship shifted a cell,
+// turned about its top or left end, or moved anywhere
+//######################
+Layout mutate(const Game& g, const Layout& fleet, mt19937& rng)
+{
+    for (;;)
+    {
+        Layout next = fleet;
+        GameRecord::Placement& pl = next[rng() % next.size()];
+        switch (rng() % 4)
+        {
+          case 0:  pl.topOrLeft.r += rng() % 2 == 0 ? -1 : 1; break;
+          case 1:  pl.topOrLeft.c += rng() % 2 == 0 ? -1 : 1; break;
+          case 2:  pl.dir = pl.dir == VERTICAL ? HORIZONTAL : VERTICAL; break;
+          default: pl = randomPlacement(g, rng); break;
+        }
+        if (validFleet(g, next))
+            return next;
+    }
+}
+
+//######################
+// Has the strategy attack the fleet in nGames games
+//
+// Game j seeds the strategy as replay does a record with
+// seed seed + j, so record, if given, gets game 0 as replay
+// will see it. A game the strategy hasn't won after 4 shots
+// per cell counts as that many shots.
+//######################
+Score evaluate(const Game& g, const Layout& fleet, const SearchConfig& config, GameRecord* record = nullptr)
+{
+    long long shots = 0;
+    double us = 0;
+    for (int j = 0; j < config.nGames; j++)
+    {
+        Board b(g);
+        for (int shipId = 0; shipId < g.nShips(); shipId++)
+            b.placeShip(fleet[shipId].topOrLeft, shipId, fleet[shipId].dir);
+        Player* p = createPlayer(config.strategy, config.strategy, g);
+        seedRandom((config.seed + j) * 2 + 1);
+
+        function<bool(const AttackResult&)> keep;
+        if (record != nullptr && j == 0)
+            keep = [&](const AttackResult& res)
+            {
+                // Classic records alternate shooters
+                if (!record->shots.empty())
+                {
+                    GameRecord::Shot pass = { 1, Point(-1, -1), false, false, false, -1 };
+                    record->shots.push_back(pass);
+                }
+                GameRecord::Shot shot = { 0, g.isValid(res.p) ? res.p : Point(-1, -1), res.valid,
+                                          res.shotHit, res.shipDestroyed, res.shipId };
+                record->shots.push_back(shot);
+                return true;
+            };
+        int n = attackUntilSunk(*p, b, &us, keep);
+        if (record != nullptr && j == 0)
+            record->winner = b.allShipsDestroyed() ? 0 : -1;
+        shots += n;
+        delete p;
+    }
+
+    Score score;
+    score.shots = double(shots) / config.nGames;
+    score.usPerMove = shots > 0 ? us / shots : 0;
+    score.value = config.objective == SHOTS ? score.shots : score.usPerMove;
+    return score;
+}
+
+bool sameFleet(const Layout& a, const Layout& b)
+{
+    for (size_t shipId = 0; shipId < a.size(); shipId++)
+        if (a[shipId].topOrLeft.r != b[shipId].topOrLeft.r || a[shipId].topOrLeft.c != b[shipId].topOrLeft.c ||
+            a[shipId].dir != b[shipId].dir)
+            return false;
+    return true;
+}
+
+//######################
+// Keeps the n highest-scoring distinct fleets, best first
+//######################
+void keepTop(vector<Candidate>& top, const Candidate& cand, int n)
+{
+    if (static_cast<int>(top.size()) == n && cand.score.value <= top.back().score.value)
+        return;
+    for (const Candidate& c : top)
+        if (sameFleet(c.fleet, cand.fleet))
+            return;
+    auto at = upper_bound(top.begin(), top.end(), cand,
+                          [](const Candidate& a, const Candidate& b) { return a.score.value > b.score.value; });
+    top.insert(at, cand);
+    if (static_cast<int>(top.size()) > n)
+        top.pop_back();
+}
+
+//######################
+// One annealing chain from a random fleet
+//
+// A worse neighbour is taken with probability exp(rel / T),
+// rel being its relative loss, as T cools geometrically
+// from 5% to 0.1% over the steps
+//######################
+void anneal(const Game& g, const SearchConfig& config, unsigned chainSeed, vector<Candidate>& top)
+{
+    const double T0 = 0.05;
+    const double T1 = 0.001;
+    mt19937 rng(chainSeed);
+    uniform_real_distribution<double> unit(0, 1);
+
+    Candidate current;
+    current.fleet = randomFleet(g, rng);
+    current.score = evaluate(g, current.fleet, config);
+    keepTop(top, current, config.nTop);
+    for (int step = 0; step < config.steps; step++)
+    {
+        double t = T0 * pow(T1 / T0, double(step) / config.steps);
+        Candidate next;
+        next.fleet = mutate(g, current.fleet, rng);
+        next.score = evaluate(g, next.fleet, config);
+        keepTop(top, next, config.nTop);
+        double rel = current.score.value > 0 ? (next.score.value - current.score.value) / current.score.value : 0;
+        if (rel >= 0 || unit(rng) < exp(rel / t))
+            current = next;
+    }
+}
+
+void printBoard(const Game& g, const Layout& fleet, ostream& out)
+{
+    vector<string> rows(g.rows(), string(g.cols(), '.'));
+    for (int shipId = 0; shipId < g.nShips(); shipId++)
+    {
+        const GameRecord::Placement& pl = fleet[shipId];
+        int dr = pl.dir == VERTICAL ? 1 : 0;
+        for (int i = 0; i < g.shipLength(shipId); i++)
+            rows[pl.topOrLeft.r + dr * i][pl.topOrLeft.c + (1 - dr) * i] = g.shipSymbol(shipId);
+    }
+    for (const string& row : rows)
+        out << "  " << row << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: adversary strategy [--objective shots|time] [--steps n] [--chains n] [--games n]"
+                " [--top n] [--threads n] [--seed s] [--out corpus.bsgr]" << endl;
+        return 2;
+    }
+    SearchConfig config;
+    config.strategy = argv[1];
+    string outPath = "corpus.bsgr";
+    int nThreads = thread::hardware_concurrency();
+
+    for (int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            cerr << "Missing value for " << arg << endl;
+            return 2;
+        }
+        string value = argv[++i];
+        if (arg == "--objective" && (value == "shots" || value == "time"))
+            config.objective = value == "shots" ? SHOTS : TIME;
+        else if (arg == "--steps")
+            config.steps = atoi(value.c_str());
+        else if (arg == "--chains")
+            config.nChains = atoi(value.c_str());
+        else if (arg == "--games")
+            config.nGames = max(atoi(value.c_str()), 1);
+        else if (arg == "--top")
+            config.nTop = max(atoi(value.c_str()), 1);
+        else if (arg == "--threads")
+            nThreads = atoi(value.c_str());
+        else if (arg == "--seed")
+            config.seed = strtoul(value.c_str(), nullptr, 0);
+        else if (arg == "--out")
+            outPath = value;
+        else
+        {
+            cerr << "Unknown argument " << arg << " " << value << endl;
+            return 2;
+        }
+    }
+    if (nThreads < 1)
+        nThreads = 1;
+    if (config.nChains < 1)
+        config.nChains = nThreads;
+
+    Game g(10, 10);
+    addStandardShips(g);
+    Player* probe = createPlayer(config.strategy, config.strategy, g);
+    if (probe == nullptr || probe->isHuman())
+    {
+        cerr << "Can't search against " << config.strategy << endl;
+        delete probe;
+        return 2;
+    }
+    delete probe;
+
+    // Each chain keeps its own best boards, merged at the end
+    vector<vector<Candidate>> tops(config.nChains);
+    atomic<int> next(0);
+    mutex progressLock;
+    int nDone = 0;
+    Timer timer;
+    auto worker = [&]()
+    {
+        for (int chain = next++; chain < config.nChains; chain = next++)
+        {
+            anneal(g, config, config.seed * 7919 + chain, tops[chain]);
+            lock_guard<mutex> lock(progressLock);
+            cerr << "chain " << ++nDone << "/" << config.nChains << ": best "
+                 << fixed << setprecision(1) << tops[chain].front().score.value
+                 << (config.objective == SHOTS ? " shots" : " us/move") << endl;
+        }
+    };
+    vector<thread> threads;
+    for (int t = 0; t < nThreads; t++)
+        threads.push_back(thread(worker));
+    for (thread& t : threads)
+        t.join();
+
+    vector<Candidate> top;
+    for (const vector<Candidate>& chainTop : tops)
+        for (const Candidate& cand : chainTop)
+            keepTop(top, cand, config.nTop);
+
+    RecordWriter writer;
+    if (!writer.open(outPath))
+    {
+        cerr << "Cannot write the corpus to " << outPath << endl;
+        return 1;
+    }
+    cout << top.size() << " boards from " << config.nChains << " chains of " << config.steps
+         << " steps in " << fixed << setprecision(1) << timer.elapsed() / 1000 << " s" << endl;
+    cout << "rank\tshots\tus/move" << endl;
+    for (size_t rank = 0; rank < top.size(); rank++)
+    {
+        GameRecord rec;
+        rec.rows = g.rows();
+        rec.cols = g.cols();
+        rec.seeded = true;
+        rec.seed = config.seed;
+        rec.shotsPerTurn = 1;
+        for (int shipId = 0; shipId < g.nShips(); shipId++)
+            rec.ships.push_back(ShipType(g.shipLength(shipId), g.shipSymbol(shipId), g.shipName(shipId)));
+        rec.names[0] = config.strategy;
+        rec.names[1] = "adversary" + to_string(rank + 1);
+        rec.placements[1] = top[rank].fleet;
+
+        // The strategy's own board plays no part; any fleet will do
+        mt19937 rng(config.seed + rank);
+        rec.placements[0] = randomFleet(g, rng);
+
+        Score score = evaluate(g, top[rank].fleet, config, &rec);
+        writer.write(rec);
+        cout << rank + 1 << '\t' << setprecision(1) << score.shots << '\t' << setprecision(2) << score.usPerMove << endl;
+    }
+    writer.close();
+    if (!top.empty())
+    {
+        cout << "Hardest board:" << endl;
+        printBoard(g, top.front().fleet, cout);
+    }
+    cout << "Corpus written to " << outPath << endl;
+    return 0;
+}
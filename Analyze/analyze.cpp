@@ -0,0 +1,348 @@
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -pthread Analyze/analyze.cpp Accounting.cpp Board.cpp Capture.cpp Game.cpp GameRecord.cpp Histogram.cpp Player.cpp Trace.cpp utility.cpp
+//
+// Usage:
+//   analyze [positions.txt] [--grid] [--threads n]
+//
+// Reads positions (from stdin if no file is given) and prints
+// GoodPlayer's density map and recommended shot for each, in input
+// order. Positions are analyzed in batches on all threads.
+//
+// A position is the ships' layout in the notebook's notation, one line
+// per board row: '.' for water and a ship's symbol on each of its cells.
+// An optional "shots" line lists the cells fired at so far, in order, as
+// row,col pairs; a blank line or "end" finishes the position. A "fleet"
+// line (symbol and length per ship, e.g. "fleet A5 B4 D3 S3 P2", the
+// default) sets the ships for the positions after it. Lines starting
+// with '#' are ignored.
+//
+//   fleet A5 B4 C3 S3 D2
+//   ..........
+//   ...AAAAA..
+//   ..........
+//   ..........
+//   .....D....
+//   .....D....
+//   ....CCC...
+//   .S........
+//   .S........
+//   .S..BBBB..
+//   shots 4,4 4,5 5,5
+//
+// Each position prints one line: its number (from 1), the recommended
+// row and column, and the density for every cell, row by row; or its
+// number and "error" with the reason. --grid prints the map as a grid.
+
+#include "../Game.h"
+#include "../Player.h"
+#include "../Board.h"
+#include "../globals.h"
+#include "../utility.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <cctype>
+
+using namespace std;
+
+const int BATCH = 4096;
+
+struct ShipSpec
+{
+    char symbol;
+    int length;
+};
+
+struct Position
+{
+    vector<ShipSpec> fleet;
+    vector<string> rows;
+    vector<Point> shots;
+    string error;        // set while reading if malformed
+};
+
+struct Analysis
+{
+    string error;
+    Point best;
+    int rows;
+    int cols;
+    int density[MAXCELLS];
+};
+
+//######################
+// Parses a fleet line's specs, or returns false
+//######################
+bool parseFleet(istringstream& in, vector<ShipSpec>& fleet)
+{
+    fleet.clear();
+    string spec;
+    while (in >> spec)
+    {
+        int length = atoi(spec.c_str() + 1);
+        char symbol = spec[0];
+        if (spec.size() < 2 || length < 1 || length > MAXLENGTH || !isascii(symbol) ||
+            !isprint(symbol) || symbol == '.' || symbol == 'X' || symbol == 'o')
+            return false;
+        for (const ShipSpec& other : fleet)
+            if (other.symbol == symbol)
+                return false;
+        fleet.push_back(ShipSpec{ symbol, length });
+    }
+    return !fleet.empty();
+}
+
+//######################
+// Reads the next position, keeping the current fleet in fleet
+// Returns false at the end of the input
+//######################
+bool readPosition(istream& in, vector<ShipSpec>& fleet, Position& pos)
+{
+    pos.rows.clear();
+    pos.shots.clear();
+    pos.error.clear();
+    string line;
+    while (getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (!line.empty() && line[0] == '#')
+            continue;
+        istringstream fields(line);
+        string word;
+        fields >> word;
+        if (word.empty() || word == "end")
+        {
+            if (pos.rows.empty() && pos.shots.empty() && pos.error.empty())
+                continue;
+            break;
+        }
+        if (word == "fleet")
+        {
+            if (!parseFleet(fields, fleet) && pos.error.empty())
+                pos.error = "bad fleet line";
+        }
+        else if (word == "shots")
+        {
+            string shot;
+            while (fields >> shot)
+            {
+                int r, c;
+                char comma;
+                istringstream cell(shot);
+                if (!(cell >> r >> comma >> c) || comma != ',')
+                {
+                    if (pos.error.empty())
+                        pos.error = "bad shot " + shot;
+                    continue;
+                }
+                pos.shots.push_back(Point(r, c));
+            }
+        }
+        else
+            pos.rows.push_back(word);
+    }
+    pos.fleet = fleet;
+    return !pos.rows.empty() || !pos.shots.empty() || !pos.error.empty();
+}
+
+//######################
+// Builds the board a position describes, fires its shots
+// with a GoodPlayer, and asks it for its density map
+//######################
+void analyze(const Position& pos, unique_ptr<Game>& game, string& gameKey, Analysis& result)
+{
+    result.error = pos.error;
+    if (!result.error.empty())
+        return;
+    if (pos.rows.empty())
+    {
+        result.error = "no board rows";
+        return;
+    }
+    result.rows = static_cast<int>(pos.rows.size());
+    result.cols = static_cast<int>(pos.rows[0].size());
+    if (result.rows > MAXROWS || result.cols > MAXCOLS)
+    {
+        result.error = "board larger than " + to_string(MAXROWS) + "x" + to_string(MAXCOLS);
+        return;
+    }
+    for (const string& row : pos.rows)
+    {
+        if (static_cast<int>(row.size()) != result.cols)
+        {
+            result.error = "rows of different lengths";
+            return;
+        }
+        for (char ch : row)
+        {
+            bool known = ch == '.';
+            for (const ShipSpec& ship : pos.fleet)
+                known = known || ch == ship.symbol;
+            if (!known)
+            {
+                result.error = string("unknown symbol ") + ch;
+                return;
+            }
+        }
+    }
+
+    // Reuse the last game if the board size and fleet are the same
+    string key = to_string(result.rows) + "x" + to_string(result.cols);
+    for (const ShipSpec& ship : pos.fleet)
+        key += " " + string(1, ship.symbol) + to_string(ship.length);
+    if (game == nullptr || key != gameKey)
+    {
+        // Game::addShip would print its complaints, so check first
+        int cells = 0;
+        for (const ShipSpec& ship : pos.fleet)
+        {
+            cells += ship.length;
+            if (ship.length > result.rows && ship.length > result.cols)
+            {
+                result.error = string("ship ") + ship.symbol + " is longer than the board";
+                return;
+            }
+        }
+        if (cells > result.rows * result.cols)
+        {
+            result.error = "fleet does not fit on the board";
+            return;
+        }
+        game.reset(new Game(result.rows, result.cols));
+        game->setVerbose(false);
+        for (const ShipSpec& ship : pos.fleet)
+            if (!game->addShip(ship.length, ship.symbol, string(1, ship.symbol)))
+            {
+                game.reset();
+                result.error = "bad fleet";
+                return;
+            }
+        gameKey = key;
+    }
+
+    Board b(*game);
+    if (!b.placeLayout(pos.rows))
+    {
+        result.error = "a ship is not laid out in a line of its length";
+        return;
+    }
+
+    unique_ptr<Player> p(createPlayer("good", "analyst", *game));
+    for (const Point& shot : pos.shots)
+    {
+        bool shotHit;
+        bool shipDestroyed;
+        int shipId;
+        bool valid = b.attack(shot, shotHit, shipDestroyed, shipId);
+        p->recordAttackResult(shot, valid, shotHit, shipDestroyed, shipId);
+    }
+    p->densityMap(result.density, result.best);
+}
+
+void print(const Analysis& a, long long number, bool grid, ostream& out)
+{
+    if (!a.error.empty())
+    {
+        out << number << " error " << a.error << '\n';
+        return;
+    }
+    out << number << ' ' << a.best.r << ' ' << a.best.c;
+    if (!grid)
+    {
+        for (int r = 0; r < a.rows; r++)
+            for (int c = 0; c < a.cols; c++)
+                out << ' ' << a.density[cellIndex(Point(r, c))];
+        out << '\n';
+        return;
+    }
+    out << '\n';
+    for (int r = 0; r < a.rows; r++)
+    {
+        for (int c = 0; c < a.cols; c++)
+            out << setw(5) << a.density[cellIndex(Point(r, c))];
+        out << '\n';
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    string path;
+    bool grid = false;
+    int nThreads = thread::hardware_concurrency();
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--grid")
+            grid = true;
+        else if (arg == "--threads" && i + 1 < argc)
+            nThreads = atoi(argv[++i]);
+        else if (arg[0] != '-' && path.empty())
+            path = arg;
+        else
+        {
+            cerr << "Usage: analyze [positions.txt] [--grid] [--threads n]" << endl;
+            return 2;
+        }
+    }
+    if (nThreads < 1)
+        nThreads = 1;
+
+    ifstream file;
+    if (!path.empty())
+    {
+        file.open(path);
+        if (!file)
+        {
+            cerr << "Cannot read " << path << endl;
+            return 1;
+        }
+    }
+    istream& in = path.empty() ? cin : file;
+
+    vector<ShipSpec> fleet = { { 'A', 5 }, { 'B', 4 }, { 'D', 3 }, { 'S', 3 }, { 'P', 2 } };
+    vector<Position> batch(BATCH);
+    vector<Analysis> results(BATCH);
+    long long done = 0;
+    Timer timer;
+    while (true)
+    {
+        // Read a batch, analyze it on every thread, print it in order
+        int n = 0;
+        while (n < BATCH && readPosition(in, fleet, batch[n]))
+            n++;
+        if (n == 0)
+            break;
+
+        atomic<int> next(0);
+        auto worker = [&]()
+        {
+            unique_ptr<Game> game;
+            string gameKey;
+            for (int k = next++; k < n; k = next++)
+                analyze(batch[k], game, gameKey, results[k]);
+        };
+        vector<thread> threads;
+        for (int t = 1; t < nThreads && t < n; t++)
+            threads.push_back(thread(worker));
+        worker();
+        for (thread& t : threads)
+            t.join();
+
+        for (int k = 0; k < n; k++)
+            print(results[k], done + k + 1, grid, cout);
+        cout.flush();
+        done += n;
+        if (n < BATCH)
+            break;
+    }
+    cerr << done << " positions in " << fixed << setprecision(1) << timer.elapsed() << " ms" << endl;
+    return 0;
+}
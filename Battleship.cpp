@@ -0,0 +1,305 @@
+#include "Battleship.h"
+#include "Game.h"
+#include "Board.h"
+#include "Player.h"
+#include "Tournament.h"
+#include "globals.h"
+#include "utility.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <new>
+#include <cctype>
+
+using namespace std;
+
+struct bs_game
+{
+    bs_game(int rows, int cols) : game(rows, cols), nPositions(0)
+    {
+        game.setVerbose(false);
+    }
+    Game game;
+    atomic<int> nPositions;   // ships can't be added while any exist
+};
+
+struct bs_position
+{
+    bs_position(const bs_game* owner, Player* p) : owner(owner), board(owner->game), player(p) {}
+    const bs_game* owner;
+    Board board;
+    unique_ptr<Player> player;
+};
+
+namespace
+{
+    thread_local string lastError;
+
+    int fail(const string& why)
+    {
+        lastError = why;
+        return -1;
+    }
+
+    bool validCell(const bs_position* pos, int row, int col)
+    {
+        return pos->owner->game.isValid(Point(row, col));
+    }
+}
+
+//******************** Library functions ******************************
+
+int bs_abi_version(void)
+{
+    return BS_ABI_VERSION;
+}
+
+const char* bs_last_error(void)
+{
+    return lastError.c_str();
+}
+
+void bs_seed(unsigned seed)
+{
+    seedRandom(seed);
+}
+
+//******************** Game functions *********************************
+
+bs_game* bs_game_new(int rows, int cols)
+{
+    // Game exits on a bad size, so check first
+    if (rows < 1 || rows > MAXROWS || cols < 1 || cols > MAXCOLS)
+    {
+        fail("board must be 1x1 to " + to_string(MAXROWS) + "x" + to_string(MAXCOLS));
+        return nullptr;
+    }
+    try
+    {
+        return new bs_game(rows, cols);
+    }
+    catch (const bad_alloc&)
+    {
+        fail("out of memory");
+        return nullptr;
+    }
+}
+
+void bs_game_free(bs_game* game)
+{
+    delete game;
+}
+
+//####################
+// Adds a ship, checking everything Game::addShip
+// would otherwise complain about on cout
+//####################
+int bs_game_add_ship(bs_game* game, int length, char symbol, const char* name)
+{
+    if (game == nullptr || name == nullptr)
+        return fail("null argument");
+    if (game->nPositions > 0)
+        return fail("ships must be added before any position is made");
+    const Game& g = game->game;
+    if (length < 1 || (length > g.rows() && length > g.cols()))
+        return fail("ship length " + to_string(length) + " won't fit on the board");
+    if (!isascii(symbol) || !isprint(symbol) || symbol == 'X' || symbol == '.' || symbol == 'o')
+        return fail(string("ship symbol ") + symbol + " is not allowed");
+    if (g.fleet().idOf(symbol) != -1)
+        return fail(string("ship symbol ") + symbol + " is already used");
+    if (g.fleet().totalCells + length > g.rows() * g.cols())
+        return fail("board is too small to fit all ships");
+    if (!game->game.addShip(length, symbol, name))
+        return fail(string("ship name ") + name + " is already used");
+    return 0;
+}
+
+//####################
+// Adds the classic fleet, checking all of it first
+// so a game that can't take it is left empty
+//####################
+int bs_game_add_standard_ships(bs_game* game)
+{
+    if (game == nullptr)
+        return fail("null argument");
+    if (game->nPositions > 0)
+        return fail("ships must be added before any position is made");
+    const Game& g = game->game;
+    if (g.nShips() > 0)
+        return fail("the standard fleet needs a game with no ships");
+
+    // The ships addStandardShips adds
+    const int lengths[] = { 5, 4, 3, 3, 2 };
+    int cells = 0;
+    for (int length : lengths)
+    {
+        if (length > g.rows() && length > g.cols())
+            return fail("ship length " + to_string(length) + " won't fit on the board");
+        cells += length;
+    }
+    if (cells > g.rows() * g.cols())
+        return fail("board is too small to fit all ships");
+    if (!addStandardShips(game->game))
+        return fail("the standard fleet could not be added");
+    return 0;
+}
+
+int bs_game_rows(const bs_game* game)
+{
+    return game == nullptr ? fail("null argument") : game->game.rows();
+}
+
+int bs_game_cols(const bs_game* game)
+{
+    return game == nullptr ? fail("null argument") : game->game.cols();
+}
+
+int bs_game_ships(const bs_game* game)
+{
+    return game == nullptr ? fail("null argument") : game->game.nShips();
+}
+
+//******************** Position functions *****************************
+
+bs_position* bs_position_new(const bs_game* game, const char* strategy)
+{
+    if (game == nullptr || strategy == nullptr)
+    {
+        fail("null argument");
+        return nullptr;
+    }
+    if (string(strategy) == "human")
+    {
+        fail("a human strategy can't be driven from here");
+        return nullptr;
+    }
+    try
+    {
+        Player* p = createPlayer(strategy, strategy, game->game);
+        if (p == nullptr)
+        {
+            fail(string("unknown strategy ") + strategy);
+            return nullptr;
+        }
+        bs_position* pos = new bs_position(game, p);
+        const_cast<bs_game*>(game)->nPositions++;
+        return pos;
+    }
+    catch (const bad_alloc&)
+    {
+        fail("out of memory");
+        return nullptr;
+    }
+}
+
+void bs_position_free(bs_position* pos)
+{
+    if (pos == nullptr)
+        return;
+    const_cast<bs_game*>(pos->owner)->nPositions--;
+    delete pos;
+}
+
+int bs_position_place(bs_position* pos, int shipId, int row, int col, int vertical)
+{
+    if (pos == nullptr)
+        return fail("null argument");
+    if (!pos->board.placeShip(Point(row, col), shipId, vertical ? VERTICAL : HORIZONTAL))
+        return fail("ship " + to_string(shipId) + " can't go at (" + to_string(row) + "," + to_string(col) + ")");
+    return 0;
+}
+
+int bs_position_place_layout(bs_position* pos, const char* layout)
+{
+    if (pos == nullptr || layout == nullptr)
+        return fail("null argument");
+    vector<string> rows;
+    string row;
+    for (const char* p = layout; ; p++)
+    {
+        if (*p == '\n' || *p == '\0')
+        {
+            if (!row.empty() && row.back() == '\r')
+                row.pop_back();
+            if (!row.empty())
+                rows.push_back(row);
+            row.clear();
+            if (*p == '\0')
+                break;
+        }
+        else if (*p != ' ' && *p != '\t')
+            row += *p;
+    }
+    if (!pos->board.placeLayout(rows))
+        return fail("layout doesn't match the board size and fleet");
+    return 0;
+}
+
+int bs_position_shoot(bs_position* pos, int row, int col, int* hit, int* destroyed, int* shipId)
+{
+    if (pos == nullptr)
+        return fail("null argument");
+    Point p(row, col);
+    bool shotHit;
+    bool shipDestroyed;
+    int id;
+    bool valid = pos->board.attack(p, shotHit, shipDestroyed, id);
+    pos->player->recordAttackResult(p, valid, shotHit, shipDestroyed, id);
+    if (hit != nullptr)
+        *hit = shotHit;
+    if (destroyed != nullptr)
+        *destroyed = shipDestroyed;
+    if (shipId != nullptr)
+        *shipId = id;
+    return valid ? 1 : 0;
+}
+
+int bs_position_record(bs_position* pos, int row, int col, int valid, int hit, int destroyed, int shipId)
+{
+    if (pos == nullptr)
+        return fail("null argument");
+    if (destroyed && (shipId < 0 || shipId >= pos->owner->game.nShips()))
+        return fail("a destroyed ship needs its id");
+    if (valid && !validCell(pos, row, col))
+        return fail("a valid shot must be on the board");
+    pos->player->recordAttackResult(Point(row, col), valid != 0, hit != 0, destroyed != 0, shipId);
+    return 0;
+}
+
+int bs_position_density(bs_position* pos, int32_t* density, int rows, int cols, int* bestRow, int* bestCol)
+{
+    if (pos == nullptr || density == nullptr)
+        return fail("null argument");
+    const Game& g = pos->owner->game;
+    if (rows != g.rows() || cols != g.cols())
+        return fail("buffer is " + to_string(rows) + "x" + to_string(cols) + ", board is " +
+                    to_string(g.rows()) + "x" + to_string(g.cols()));
+    int map[MAXCELLS];
+    Point best;
+    if (!pos->player->densityMap(map, best))
+        return fail("strategy " + pos->player->name() + " has no density map");
+    for (int r = 0; r < rows; r++)
+        for (int c = 0; c < cols; c++)
+            density[r * cols + c] = map[cellIndex(Point(r, c))];
+    if (bestRow != nullptr)
+        *bestRow = best.r;
+    if (bestCol != nullptr)
+        *bestCol = best.c;
+    return 0;
+}
+
+int bs_position_recommend(bs_position* pos, int* row, int* col)
+{
+    if (pos == nullptr || row == nullptr || col == nullptr)
+        return fail("null argument");
+    Point p = pos->player->recommendAttack();
+    *row = p.r;
+    *col = p.c;
+    return 0;
+}
+
+int bs_position_ships_afloat(const bs_position* pos)
+{
+    return pos == nullptr ? fail("null argument") : pos->board.nShipsAfloat();
+}
@@ -0,0 +1,89 @@
+#ifndef BATTLESHIP_INCLUDED
+#define BATTLESHIP_INCLUDED
+
+  // C interface to the game core, for use from other languages
+  //
+  // Build the shared library from the repository root:
+  //   g++ -std=c++17 -O2 -fPIC -shared -fvisibility=hidden -pthread -DNO_HEAP_ACCOUNTING
+  //       Battleship.cpp Accounting.cpp Board.cpp Capture.cpp Game.cpp GameRecord.cpp Histogram.cpp
+  //       OpponentModel.cpp Player.cpp ResultStore.cpp Shard.cpp Sprt.cpp Tournament.cpp Trace.cpp utility.cpp
+  //       -o libbattleship.so
+  //
+  // A bs_game holds the board size and fleet; a bs_position is a board
+  // of that game with ships placed and shots fired, plus one strategy's
+  // knowledge of it. A game must outlive its positions. Functions
+  // returning int give 0 (or a count) on success and -1 on failure, with
+  // the reason in bs_last_error(). Nothing here keeps a pointer passed
+  // in after returning, and output buffers belong to the caller.
+  //
+  // Functions may be called from several threads as long as no handle
+  // is used by two threads at once.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define BS_API __attribute__((visibility("default")))
+#else
+#define BS_API
+#endif
+
+  // Bumped whenever a signature or behavior here changes incompatibly
+#define BS_ABI_VERSION 1
+
+typedef struct bs_game bs_game;
+typedef struct bs_position bs_position;
+
+BS_API int bs_abi_version(void);
+BS_API const char* bs_last_error(void);
+
+  // Makes the calling thread's random numbers repeatable
+BS_API void bs_seed(unsigned seed);
+
+BS_API bs_game* bs_game_new(int rows, int cols);
+BS_API void bs_game_free(bs_game* game);
+BS_API int bs_game_add_ship(bs_game* game, int length, char symbol, const char* name);
+  // Adds the five ships of the classic game
+BS_API int bs_game_add_standard_ships(bs_game* game);
+BS_API int bs_game_rows(const bs_game* game);
+BS_API int bs_game_cols(const bs_game* game);
+BS_API int bs_game_ships(const bs_game* game);
+
+  // strategy is a player type such as "good" or "mediocre"
+BS_API bs_position* bs_position_new(const bs_game* game, const char* strategy);
+BS_API void bs_position_free(bs_position* pos);
+
+  // Places one ship, or all of them from a layout of rows separated
+  // by newlines ('.' for water, a ship's symbol on each of its cells)
+BS_API int bs_position_place(bs_position* pos, int shipId, int row, int col, int vertical);
+BS_API int bs_position_place_layout(bs_position* pos, const char* layout);
+
+  // Fires at the board and tells the strategy the result; hit,
+  // destroyed and shipId may be null. Returns 1 for a valid shot,
+  // 0 for an invalid one, -1 on error
+BS_API int bs_position_shoot(bs_position* pos, int row, int col, int* hit, int* destroyed, int* shipId);
+
+  // Tells the strategy about a shot fired elsewhere (no board needed)
+BS_API int bs_position_record(bs_position* pos, int row, int col, int valid, int hit,
+                              int destroyed, int shipId);
+
+  // Fills density, a caller-owned row-major rows x cols buffer, with
+  // the strategy's score for every cell, in place; bestRow and bestCol
+  // (if not null) get the cell it would attack
+BS_API int bs_position_density(bs_position* pos, int32_t* density, int rows, int cols,
+                               int* bestRow, int* bestCol);
+
+  // The cell the strategy would attack next
+BS_API int bs_position_recommend(bs_position* pos, int* row, int* col);
+
+  // Ships not yet sunk on the board
+BS_API int bs_position_ships_afloat(const bs_position* pos);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BATTLESHIP_INCLUDED
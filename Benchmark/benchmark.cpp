@@ -0,0 +1,624 @@
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -pthread Benchmark/benchmark.cpp Accounting.cpp Board.cpp Capture.cpp Game.cpp GameRecord.cpp Histogram.cpp OpponentModel.cpp Player.cpp ResultStore.cpp Shard.cpp Sprt.cpp Tournament.cpp Trace.cpp utility.cpp
+// 
+// Usage:
+//   benchmark [--out results.tsv] [--baseline Benchmark/baseline.tsv] [--tolerance 0.15] [--quick]
+//             [--corpus corpus.bsgr]
+// 
+// Writes one tab-separated line per benchmark. With --baseline, any
+// benchmark whose median is more than tolerance above the baseline's
+// is reported and the exit status is 1. --corpus adds benchmarks on
+// the hard boards of a corpus written by the adversary tool.
+
+#include "../Game.h"
+#include "../Player.h"
+#include "../Board.h"
+#include "../globals.h"
+#include "../utility.h"
+#include "../Tournament.h"
+#include "../Histogram.h"
+#include "../Accounting.h"
+#include "../GameRecord.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <functional>
+#include <cstdlib>
+#include <cmath>
+
+using namespace std;
+
+//*********************************************************************
+//  Measurement
+//*********************************************************************
+
+// Summary of one benchmark's samples
+struct BenchResult
+{
+    string name;
+    string unit;
+    double median;
+    double mad;      // median absolute deviation
+    double min;
+    int reps;
+};
+
+vector<BenchResult> results;
+
+// Number of untimed warm-up samples and timed samples per benchmark
+int nWarmup = 20;
+int nReps = 200;
+
+double medianOf(vector<double> v)
+{
+    if (v.empty())
+        return 0;
+    size_t mid = v.size() / 2;
+    nth_element(v.begin(), v.begin() + mid, v.end());
+    double m = v[mid];
+    if (v.size() % 2 == 0)
+        m = (m + *max_element(v.begin(), v.begin() + mid)) / 2;
+    return m;
+}
+
+//######################
+// Runs sample() for the warm-up, then nReps times,
+// and keeps robust statistics of what it returns
+// 
+// Medians and MAD ignore the occasional preempted sample
+//######################
+void measure(string name, string unit, function<double()> sample)
+{
+    for (int i = 0; i < nWarmup; i++)
+        sample();
+
+    vector<double> values;
+    for (int i = 0; i < nReps; i++)
+        values.push_back(sample());
+
+    double median = medianOf(values);
+    vector<double> deviations;
+    for (double v : values)
+        deviations.push_back(fabs(v - median));
+
+    BenchResult res = { name, unit, median, medianOf(deviations),
+                        *min_element(values.begin(), values.end()), nReps };
+    results.push_back(res);
+    cerr << setw(40) << left << name << right << fixed << setprecision(1)
+         << setw(12) << median << " " << unit << "  (mad " << res.mad << ")" << endl;
+}
+
+// Records a single deterministic value, such as a byte count
+void record(string name, string unit, double value)
+{
+    BenchResult res = { name, unit, value, 0, value, 1 };
+    results.push_back(res);
+    cerr << setw(40) << left << name << right << fixed << setprecision(1)
+         << setw(12) << value << " " << unit << endl;
+}
+
+//*********************************************************************
+//  Board benchmarks
+//*********************************************************************
+
+void boardBenchmarks()
+{
+    const int OPS = 1000;
+    Game g(10, 10);
+    addStandardShips(g);
+    Player* placer = createPlayer("good", "placer", g);
+
+    measure("board.placeShip+unplaceShip", "ns/op", [&]
+    {
+        Board b(g);
+        Timer timer;
+        for (int i = 0; i < OPS; i++)
+        {
+            Point p(i % 6, (i / 6) % 10);
+            b.placeShip(p, 0, VERTICAL);
+            b.unplaceShip(p, 0, VERTICAL);
+        }
+        return timer.elapsed() * 1e6 / OPS;
+    });
+
+    measure("board.attack", "ns/op", [&]
+    {
+        Board b(g);
+        placer->placeShips(b);
+        bool shotHit, shipDestroyed;
+        int shipId;
+        Timer timer;
+        for (int r = 0; r < g.rows(); r++)
+            for (int c = 0; c < g.cols(); c++)
+                b.attack(Point(r, c), shotHit, shipDestroyed, shipId);
+        return timer.elapsed() * 1e6 / (g.rows() * g.cols());
+    });
+
+    measure("board.allShipsDestroyed", "ns/op", [&]
+    {
+        Board b(g);
+        placer->placeShips(b);
+        int destroyed = 0;
+        Timer timer;
+        for (int i = 0; i < OPS; i++)
+            destroyed += b.allShipsDestroyed();
+        double ns = timer.elapsed() * 1e6 / OPS;
+        return ns + destroyed * 0.0;
+    });
+
+    delete placer;
+}
+
+//*********************************************************************
+//  Game benchmarks
+//*********************************************************************
+
+void gameBenchmarks()
+{
+    const string matches[][2] = {
+        { "mediocre", "mediocre" }, { "mediocre", "good" }, { "good", "good" }
+    };
+
+    for (const auto& match : matches)
+    {
+        measure("game.play." + match[0] + "-" + match[1], "us/game", [&]
+        {
+            Game g(10, 10);
+            addStandardShips(g);
+            g.setVerbose(false);
+            Player* p1 = createPlayer(match[0], "p1", g);
+            Player* p2 = createPlayer(match[1], "p2", g);
+            Timer timer;
+            g.play(p1, p2, false);
+            double us = timer.elapsed() * 1e3;
+            delete p1;
+            delete p2;
+            return us;
+        });
+    }
+}
+
+//*********************************************************************
+//  Strategy benchmarks
+//*********************************************************************
+
+//######################
+// Times one recommendAttack call of a strategy in a phase
+// 
+// The player first plays against a fresh board (untimed)
+// until the phase is reached:
+//   early hunt   after 3 shots
+//   mid-game     after 40 shots, with no ship partly hit
+//   target mode  right after a hit that did not sink a ship
+// A fleet sunk first leaves nothing to choose, so the
+// player starts over on another board
+//######################
+double phaseSample(const string& type, GamePhase phase)
+{
+    while (true)
+    {
+        Game g(10, 10);
+        addStandardShips(g);
+        Board b(g);
+        Player* placer = createPlayer("good", "placer", g);
+        placer->placeShips(b);
+        Player* p = createPlayer(type, type, g);
+
+        int partlyHit = 0;
+        bool reached = false;
+        for (int shot = 0; shot < 100 && !b.allShipsDestroyed(); shot++)
+        {
+            reached = (phase == EARLY_HUNT && shot >= 3) ||
+                      (phase == MID_GAME && shot >= 40 && partlyHit == 0) ||
+                      (phase == TARGET_MODE && partlyHit > 0);
+            if (reached)
+                break;
+
+            bool shotHit, shipDestroyed;
+            int shipId;
+            Point a = p->recommendAttack();
+            bool valid = b.attack(a, shotHit, shipDestroyed, shipId);
+            p->recordAttackResult(a, valid, shotHit, shipDestroyed, shipId);
+            if (shotHit)
+                partlyHit = shipDestroyed ? 0 : partlyHit + 1;
+        }
+
+        double us = 0;
+        if (reached)
+        {
+            Timer timer;
+            p->recommendAttack();
+            us = timer.elapsed() * 1e3;
+        }
+        delete p;
+        delete placer;
+        if (reached)
+            return us;
+    }
+}
+
+void strategyBenchmarks()
+{
+    const string types[] = { "awful", "mediocre", "good" };
+    const string phaseNames[] = { "early", "mid", "target" };
+
+    for (const string& type : types)
+        for (int phase = EARLY_HUNT; phase <= TARGET_MODE; phase++)
+            measure("recommendAttack." + type + "." + phaseNames[phase], "us/call",
+                    [&] { return phaseSample(type, GamePhase(phase)); });
+}
+
+//*********************************************************************
+//  Memory benchmark
+//*********************************************************************
+
+// Everything one in-flight game keeps alive
+struct ConcurrentGame
+{
+    Game* game;
+    Board* boards[2];
+    Player* players[2];
+};
+
+//######################
+// Holds nGames standard 10x10 games open at once,
+// each played shotsEach turns into the midgame,
+// and reports the heap bytes held per game
+//######################
+void memoryBenchmark(string type, int nGames, int shotsEach)
+{
+    size_t before = heapLiveBytes();
+    vector<ConcurrentGame> games;
+    games.reserve(nGames);
+    size_t reserved = heapLiveBytes() - before;
+
+    for (int n = 0; n < nGames; n++)
+    {
+        ConcurrentGame cg;
+        cg.game = new Game(10, 10);
+        addStandardShips(*cg.game);
+        for (int k = 0; k < 2; k++)
+        {
+            cg.boards[k] = new Board(*cg.game);
+            cg.players[k] = createPlayer(type, type, *cg.game);
+            cg.players[k]->placeShips(*cg.boards[k]);
+        }
+
+        // Play into the midgame without Game::play's output
+        for (int s = 0; s < shotsEach; s++)
+        {
+            for (int k = 0; k < 2; k++)
+            {
+                bool shotHit, shipDestroyed;
+                int shipId;
+                Point p = cg.players[k]->recommendAttack();
+                bool valid = cg.boards[1 - k]->attack(p, shotHit, shipDestroyed, shipId);
+                cg.players[k]->recordAttackResult(p, valid, shotHit, shipDestroyed, shipId);
+                cg.players[1 - k]->recordAttackByOpponent(p);
+            }
+        }
+        games.push_back(cg);
+    }
+
+    double perGame = double(heapLiveBytes() - before - reserved) / nGames + sizeof(ConcurrentGame);
+    record("memory." + type + ".shots" + to_string(shotsEach), "bytes/game", perGame);
+
+    for (ConcurrentGame& cg : games)
+    {
+        for (int k = 0; k < 2; k++)
+        {
+            delete cg.players[k];
+            delete cg.boards[k];
+        }
+        delete cg.game;
+    }
+}
+
+void memoryBenchmarks(int nGames)
+{
+    const string types[] = { "awful", "mediocre", "good" };
+    for (const string& type : types)
+    {
+        memoryBenchmark(type, nGames, 0);
+        memoryBenchmark(type, nGames, 40);
+    }
+}
+
+//*********************************************************************
+//  Salvo benchmark
+//*********************************************************************
+
+//######################
+// Fires every cell of a freshly placed board in salvos of k,
+// through Board::attack or through Board::attackMany
+//######################
+void salvoBenchmark(int k)
+{
+    Game g(10, 10);
+    addStandardShips(g);
+    Player* placer = createPlayer("good", "placer", g);
+
+    // Every cell in row-major order
+    vector<Point> cells;
+    for (int r = 0; r < g.rows(); r++)
+        for (int c = 0; c < g.cols(); c++)
+            cells.push_back(Point(r, c));
+
+    for (int batched = 0; batched < 2; batched++)
+    {
+        string name = string("salvo.") + (batched ? "attackMany" : "attack") + ".k" + to_string(k);
+        measure(name, "ns/shot", [&]
+        {
+            AttackResult shots[MAXCELLS];
+            Board b(g);
+            placer->placeShips(b);
+            Timer timer;
+            for (size_t first = 0; first < cells.size(); first += k)
+            {
+                int nShots = min<int>(k, cells.size() - first);
+                if (batched)
+                    b.attackMany(&cells[first], nShots, shots);
+                else
+                {
+                    for (int s = 0; s < nShots; s++)
+                    {
+                        AttackResult& res = shots[s];
+                        res.valid = b.attack(cells[first + s], res.shotHit, res.shipDestroyed, res.shipId);
+                    }
+                }
+            }
+            return timer.elapsed() * 1e6 / cells.size();
+        });
+    }
+    delete placer;
+}
+
+//*********************************************************************
+//  Placement benchmark
+//*********************************************************************
+
+//######################
+// Shots an attacker of a type takes to sink a placed board,
+// or 4 per cell if it never does
+//######################
+int shotsToSink(Board& b, const Game& g, const string& type)
+{
+    Player* p = createPlayer(type, type, g);
+    int shots = attackUntilSunk(*p, b);
+    delete p;
+    return shots;
+}
+
+//######################
+// What simulation-scored placement with k candidates costs per
+// game, and what it buys: the shots good (the rollouts' own
+// attacker) and mediocre need to sink the fleets it places,
+// averaged over nFleets; k = 1 is random placement
+//######################
+void placementBenchmark(int k, int nFleets)
+{
+    Game g(10, 10);
+    addStandardShips(g);
+    RolloutBudget budget = { k, 1e6, 1 };
+    string name = "placement.sturdy.k" + to_string(k);
+
+    measure(name, "us/placement", [&]
+    {
+        Board b(g);
+        Timer timer;
+        placeSturdyFleet(b, g, budget);
+        return timer.elapsed() * 1e3;
+    });
+
+    const string types[] = { "good", "mediocre" };
+    for (const string& type : types)
+    {
+        seedRandom(1);
+        long long total = 0;
+        for (int n = 0; n < nFleets; n++)
+        {
+            Board b(g);
+            placeSturdyFleet(b, g, budget);
+            total += shotsToSink(b, g, type);
+        }
+        record(name + ".survival." + type, "shots", double(total) / nFleets);
+    }
+}
+
+//*********************************************************************
+//  Corpus benchmark
+//*********************************************************************
+
+//######################
+// Shots and time per move of a strategy sinking the second player's
+// fleet of a record, seeded as replay would; shots is -1 if the
+// board can't be rebuilt
+//######################
+void attackRecord(const GameRecord& rec, const string& type, int& shots, double& usPerMove)
+{
+    shots = -1;
+    usPerMove = 0;
+    Game g(rec.rows, rec.cols);
+    for (const ShipType& st : rec.ships)
+        if (!g.addShip(st.length, st.symbol, st.name))
+            return;
+    Board b(g);
+    for (int shipId = 0; shipId < g.nShips(); shipId++)
+        if (!b.placeShip(rec.placements[1][shipId].topOrLeft, shipId, rec.placements[1][shipId].dir))
+            return;
+
+    Player* p = createPlayer(type, type, g);
+    seedRandom(rec.seed * 2 + 1);
+    double us = 0;
+    shots = attackUntilSunk(*p, b, &us);
+    usPerMove = shots > 0 ? us / shots : 0;
+    delete p;
+}
+
+//######################
+// Strategies on a corpus of hard boards: the mean shots
+// to sink them, and the median time per move, taking the
+// boards in turn
+//######################
+void corpusBenchmarks(const string& path)
+{
+    MappedRecords records;
+    vector<GameRecord> boards;
+    GameRecord rec;
+    if (records.open(path))
+        for (size_t n = 0; n < records.size(); n++)
+            if (records.get(n, rec) && rec.placements[1].size() == rec.ships.size())
+                boards.push_back(rec);
+    if (boards.empty())
+    {
+        cerr << "No boards in corpus " << path << endl;
+        return;
+    }
+
+    const string types[] = { "mediocre", "good" };
+    for (const string& type : types)
+    {
+        long long total = 0;
+        int nBoards = 0;
+        for (const GameRecord& board : boards)
+        {
+            int shots;
+            double us;
+            attackRecord(board, type, shots, us);
+            if (shots >= 0)
+            {
+                total += shots;
+                nBoards++;
+            }
+        }
+        record("corpus." + type + ".shots", "shots/board", nBoards > 0 ? double(total) / nBoards : 0);
+
+        size_t next = 0;
+        measure("corpus." + type + ".move", "us/move", [&]
+        {
+            int shots;
+            double us;
+            attackRecord(boards[next++ % boards.size()], type, shots, us);
+            return us;
+        });
+    }
+}
+
+//*********************************************************************
+//  Results
+//*********************************************************************
+
+void writeResults(ostream& out)
+{
+    out << "name\tunit\tmedian\tmad\tmin\treps" << endl;
+    for (const BenchResult& res : results)
+        out << res.name << '\t' << res.unit << '\t' << fixed << setprecision(3)
+            << res.median << '\t' << res.mad << '\t' << res.min << '\t' << res.reps << endl;
+}
+
+//######################
+// Compares medians against a baseline file written by writeResults
+// Returns the number of regressions beyond tolerance
+//######################
+int compareBaseline(const string& path, double tolerance)
+{
+    ifstream in(path);
+    if (!in)
+    {
+        cerr << "Cannot read baseline " << path << endl;
+        return 1;
+    }
+
+    map<string, double> baseline;
+    string line;
+    getline(in, line);  // header
+    while (getline(in, line))
+    {
+        istringstream fields(line);
+        string name, unit;
+        double median;
+        if (getline(fields, name, '\t') && getline(fields, unit, '\t') && fields >> median)
+            baseline[name] = median;
+    }
+
+    int nRegressions = 0;
+    for (const BenchResult& res : results)
+    {
+        auto it = baseline.find(res.name);
+        if (it == baseline.end() || it->second <= 0)
+            continue;
+        // Survival is the one measure where more is better
+        double ratio = res.unit == "shots" ? it->second / res.median : res.median / it->second;
+        if (ratio > 1 + tolerance)
+        {
+            cerr << "REGRESSION " << res.name << ": " << fixed << setprecision(1) << it->second
+                 << " -> " << res.median << " " << res.unit
+                 << " (+" << setprecision(0) << 100 * (ratio - 1) << "%)" << endl;
+            nRegressions++;
+        }
+    }
+    return nRegressions;
+}
+
+int main(int argc, char* argv[])
+{
+    string outPath;
+    string baselinePath;
+    double tolerance = 0.15;
+    int nMemoryGames = 10000;
+    int nFleets = 500;
+    string corpusPath;
+
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc)
+            outPath = argv[++i];
+        else if (arg == "--baseline" && i + 1 < argc)
+            baselinePath = argv[++i];
+        else if (arg == "--tolerance" && i + 1 < argc)
+            tolerance = atof(argv[++i]);
+        else if (arg == "--corpus" && i + 1 < argc)
+            corpusPath = argv[++i];
+        else if (arg == "--quick")
+        {
+            nWarmup = 5;
+            nReps = 30;
+            nMemoryGames = 1000;
+            nFleets = 100;
+        }
+        else
+        {
+            cerr << "Unknown argument " << arg << endl;
+            return 2;
+        }
+    }
+
+    boardBenchmarks();
+    gameBenchmarks();
+    strategyBenchmarks();
+    memoryBenchmarks(nMemoryGames);
+    for (int k : { 1, 5, 17 })
+        salvoBenchmark(k);
+    for (int k : { 1, 4, 16, 64 })
+        placementBenchmark(k, nFleets);
+    if (!corpusPath.empty())
+        corpusBenchmarks(corpusPath);
+
+    if (outPath.empty())
+        writeResults(cout);
+    else
+    {
+        ofstream out(outPath);
+        writeResults(out);
+    }
+
+    if (!baselinePath.empty() && compareBaseline(baselinePath, tolerance) > 0)
+        return 1;
+    return 0;
+}
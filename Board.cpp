@@ -1,6 +1,8 @@
 #include "Board.h"
 #include "Game.h"
 #include "globals.h"
+#include "utility.h"
+#include "Trace.h"
 #include <vector>
 #include <iostream>
 #include <algorithm>
@@ -18,7 +20,13 @@ class BoardImpl
     bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
     void display(bool shotsOnly) const;
     bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+    int attackMany(const Point* shots, int nShots, AttackResult* results);
     bool allShipsDestroyed() const;
+    int nShipsAfloat() const;
+    bool shipPosition(int shipId, Point& topOrLeft, Direction& dir) const;
+    bool placeLayout(const vector<string>& rows);
+    void save(ostream& out) const;
+    bool load(istream& in);
 
   private:
     struct ShipInstance
@@ -29,18 +37,23 @@ class BoardImpl
         ShipInstance(int shipId, Point topOrLeft, Direction dir) : shipId(shipId), topOrLeft(topOrLeft), dir(dir) { }
     };
 
-    bool shipInstanceDestroyed(const ShipInstance& instance) const;
-
     const Game& m_game;
+    const Fleet& m_fleet;
 
     // Stores the display grid
     char m_grid[MAXROWS][MAXCOLS];
 
     // Stores list of ship IDs, their topOrLeft positions, and placement direction
     vector<ShipInstance> m_shipInstances;
+
+    // Stores unhit cells of each placed ship, indexed by shipId
+    vector<int> m_hitsLeft;
+
+    // Stores number of placed ships with unhit cells
+    int m_shipsAfloat;
 };
 
-BoardImpl::BoardImpl(const Game& g) : m_game(g)
+BoardImpl::BoardImpl(const Game& g) : m_game(g), m_fleet(g.fleet()), m_shipsAfloat(0)
 {
     // Initialize grid with '.'
     clear();
@@ -56,6 +69,11 @@ void BoardImpl::clear()
     for (int r = 0; r < m_game.rows(); r++)
         for (int c = 0; c < m_game.cols(); c++)
             m_grid[r][c] = '.';
+
+    // No ships remain on an empty grid
+    m_shipInstances.clear();
+    m_hitsLeft.assign(m_hitsLeft.size(), 0);
+    m_shipsAfloat = 0;
 }
 
 // ##############
@@ -120,7 +138,7 @@ bool BoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
     Point current = topOrLeft;
 
     // Number of positions to loop through
-    int shipLength = m_game.shipLength(shipId);
+    int shipLength = m_fleet.lengths[shipId];
 
     // Position validation along intended ship space
     for (int i = 0; i < shipLength; i++)
@@ -143,10 +161,14 @@ bool BoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
 
     // Store ShipInstance as a part of the Board now
     m_shipInstances.push_back(ShipInstance(shipId, topOrLeft, dir));
+    if (static_cast<int>(m_hitsLeft.size()) <= shipId)
+        m_hitsLeft.resize(m_fleet.nShips, 0);
+    m_hitsLeft[shipId] = shipLength;
+    m_shipsAfloat++;
 
     // Place shipSymbols in allocated space
     current = topOrLeft;
-    int shipSymbol = m_game.shipSymbol(shipId);
+    int shipSymbol = m_fleet.symbols[shipId];
     for (int i = 0; i < shipLength; i++)
     {
         m_grid[current.r][current.c] = shipSymbol;
@@ -188,7 +210,7 @@ bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
 
     // Replace Ship's symbols with '.'
     Point current = topOrLeft;
-    int shipLength = m_game.shipLength(shipId);
+    int shipLength = m_fleet.lengths[shipId];
     for (int i = 0; i < shipLength; i++)
     {
         m_grid[current.r][current.c] = '.';
@@ -202,6 +224,9 @@ bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
     }
 
     // Remove ShipInstance
+    if (m_hitsLeft[shipId] > 0)
+        m_shipsAfloat--;
+    m_hitsLeft[shipId] = 0;
     m_shipInstances.erase(matchedSP);
 
     return true;
@@ -215,6 +240,7 @@ bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
 // #################
 void BoardImpl::display(bool shotsOnly) const
 {
+    TraceScope span("display");
     // Print column indices
     cout << "  ";
     for (int c = 0; c < m_game.cols(); c++) cout << c;
@@ -239,41 +265,6 @@ void BoardImpl::display(bool shotsOnly) const
     }
 }
 
-// ############################
-// Check if a particular ShipInstance is destroyed
-// 
-// Checks the game board for ShipInstance's symbol 
-// from topOrLeft position towards Direction
-// for shipLength number of positions
-// 
-// If no symbols left along path, return true
-// ############################
-bool BoardImpl::shipInstanceDestroyed(const ShipInstance& instance) const
-{
-    // Start position at topOrLeft
-    Point current = instance.topOrLeft;
-    int shipLength = m_game.shipLength(instance.shipId);
-    char shipSymbol = m_game.shipSymbol(instance.shipId);
-
-    // Loop up to shipLength number of positions
-    for (int i = 0; i < shipLength; i++)
-    {
-        // If symbol is along path, ShipInstance is still alive
-        if (m_grid[current.r][current.c] == shipSymbol)
-        {
-            return false;
-        }
-
-        // Increment column if Direction is HORIZONTAL
-        if (instance.dir == HORIZONTAL)
-            current.c++;
-        // Increment row if Direction is VERTICAL
-        if (instance.dir == VERTICAL)
-            current.r++;
-    }
-    return true;
-}
-
 // #########################
 // Attack a point on a board
 //  
@@ -282,6 +273,7 @@ bool BoardImpl::shipInstanceDestroyed(const ShipInstance& instance) const
 // #########################
 bool BoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
 {
+    TraceScope span("Board::attack");
     // Point is outside board or is already attacked
     if (!m_game.isValid(p) || m_grid[p.r][p.c] == 'X' || m_grid[p.r][p.c] == 'o')
     {
@@ -303,38 +295,203 @@ bool BoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
     }
 
     // Find ship by matching symbol at the Point to a shipId
-    vector<ShipInstance>::iterator matchedShipPos;
-    for (matchedShipPos = m_shipInstances.begin(); matchedShipPos != m_shipInstances.end(); matchedShipPos++)
-    {
-        // Symbol at Point matches a ship's symbol
-        if (m_grid[p.r][p.c] == m_game.shipSymbol(matchedShipPos->shipId))
-            break;
-    }
+    shipId = m_fleet.idOf(m_grid[p.r][p.c]);
 
     // Mark board position as a hit
     m_grid[p.r][p.c] = 'X';
 
-    // Check if damaged ship is destroyed
-    shipDestroyed = shipInstanceDestroyed(*matchedShipPos);
+    // Ship is destroyed when its last unhit cell is hit
+    shipDestroyed = --m_hitsLeft[shipId] == 0;
+    if (shipDestroyed)
+        m_shipsAfloat--;
     shotHit = true;
-    shipId = matchedShipPos->shipId;
     return true;
 }
 
+// #########################
+// Attack several points in one turn (Salvo)
+// 
+// Resolves shots in order in a single pass;
+// a repeated point in the same salvo is invalid
+// Returns the number of valid shots
+// #########################
+int BoardImpl::attackMany(const Point* shots, int nShots, AttackResult* results)
+{
+    TraceScope span("Board::attackMany");
+    int nValid = 0;
+    int rows = m_game.rows();
+    int cols = m_game.cols();
+
+    for (int n = 0; n < nShots; n++)
+    {
+        Point p = shots[n];
+        AttackResult& result = results[n];
+        result.p = p;
+        result.shotHit = false;
+        result.shipDestroyed = false;
+        result.shipId = -1;
+
+        // Point is outside board or is already attacked
+        result.valid = p.r >= 0 && p.r < rows && p.c >= 0 && p.c < cols &&
+                       m_grid[p.r][p.c] != 'X' && m_grid[p.r][p.c] != 'o';
+        if (!result.valid)
+            continue;
+        nValid++;
+
+        char& cell = m_grid[p.r][p.c];
+
+        // Miss
+        if (cell == '.')
+        {
+            cell = 'o';
+            continue;
+        }
+
+        // Hit
+        result.shipId = m_fleet.idOf(cell);
+        result.shotHit = true;
+        cell = 'X';
+        result.shipDestroyed = --m_hitsLeft[result.shipId] == 0;
+        if (result.shipDestroyed)
+            m_shipsAfloat--;
+    }
+    return nValid;
+}
+
 // ########################
 // Checks if all ShipInstances are destroyed
 // ########################
 bool BoardImpl::allShipsDestroyed() const
 {
-    // Loop through all ship instances
-    for (const ShipInstance& sp : m_shipInstances)
+    return m_shipsAfloat == 0;
+}
+
+// ########################
+// Counts placed ships that are not destroyed
+// ########################
+int BoardImpl::nShipsAfloat() const
+{
+    return m_shipsAfloat;
+}
+
+// ########################
+// Where a placed ship lies
+// Returns false if the ship is not on the board
+// ########################
+bool BoardImpl::shipPosition(int shipId, Point& topOrLeft, Direction& dir) const
+{
+    for (const ShipInstance& sI : m_shipInstances)
+        if (sI.shipId == shipId)
+        {
+            topOrLeft = sI.topOrLeft;
+            dir = sI.dir;
+            return true;
+        }
+    return false;
+}
+
+// ########################
+// Finds each ship's cells in the layout, row by row,
+// and places it along them
+// ########################
+bool BoardImpl::placeLayout(const vector<string>& rows)
+{
+    clear();
+    if (static_cast<int>(rows.size()) != m_game.rows())
+        return false;
+    for (const string& row : rows)
     {
-        // If ship is not destroyed
-        if (!shipInstanceDestroyed(sp))
+        if (static_cast<int>(row.size()) != m_game.cols())
             return false;
+        for (char ch : row)
+            if (ch != '.' && m_fleet.idOf(ch) < 0)
+                return false;
     }
 
-    // All ships destroyed
+    for (int shipId = 0; shipId < m_fleet.nShips; shipId++)
+    {
+        vector<Point> cells;
+        for (int r = 0; r < m_game.rows(); r++)
+            for (int c = 0; c < m_game.cols(); c++)
+                if (rows[r][c] == m_fleet.symbols[shipId])
+                    cells.push_back(Point(r, c));
+
+        int length = m_fleet.lengths[shipId];
+        if (static_cast<int>(cells.size()) != length)
+        {
+            clear();
+            return false;
+        }
+        Direction dir = length > 1 && cells[1].r != cells[0].r ? VERTICAL : HORIZONTAL;
+        for (int n = 1; n < length; n++)
+            if (cells[n].r != cells[0].r + (dir == VERTICAL ? n : 0) ||
+                cells[n].c != cells[0].c + (dir == HORIZONTAL ? n : 0))
+            {
+                clear();
+                return false;
+            }
+        if (!placeShip(cells[0], shipId, dir))
+        {
+            clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+// ########################
+// Writes the ships as id, row, column and direction,
+// then the cells that have been shot at
+// ########################
+void BoardImpl::save(ostream& out) const
+{
+    out << m_shipInstances.size();
+    for (const ShipInstance& sI : m_shipInstances)
+        out << ' ' << sI.shipId << ' ' << sI.topOrLeft.r << ' ' << sI.topOrLeft.c << ' ' << sI.dir;
+
+    int nShots = 0;
+    for (int r = 0; r < m_game.rows(); r++)
+        for (int c = 0; c < m_game.cols(); c++)
+            if (m_grid[r][c] == 'X' || m_grid[r][c] == 'o')
+                nShots++;
+    out << ' ' << nShots;
+    for (int r = 0; r < m_game.rows(); r++)
+        for (int c = 0; c < m_game.cols(); c++)
+            if (m_grid[r][c] == 'X' || m_grid[r][c] == 'o')
+                out << ' ' << r * m_game.cols() + c;
+}
+
+// ########################
+// Rebuilds a board from what save wrote by placing
+// the ships and shooting at the same cells again
+// Returns false if it is malformed
+// ########################
+bool BoardImpl::load(istream& in)
+{
+    clear();
+    size_t nShips;
+    if (!(in >> nShips) || nShips > static_cast<size_t>(m_game.nShips()))
+        return false;
+    for (size_t n = 0; n < nShips; n++)
+    {
+        int shipId, r, c, dir;
+        if (!(in >> shipId >> r >> c >> dir) || (dir != HORIZONTAL && dir != VERTICAL) ||
+            !placeShip(Point(r, c), shipId, static_cast<Direction>(dir)))
+            return false;
+    }
+
+    int nShots;
+    if (!(in >> nShots) || nShots < 0 || nShots > m_game.rows() * m_game.cols())
+        return false;
+    for (int n = 0; n < nShots; n++)
+    {
+        int cell;
+        bool shotHit, shipDestroyed;
+        int shipId;
+        if (!(in >> cell) || cell < 0 ||
+            !attack(Point(cell / m_game.cols(), cell % m_game.cols()), shotHit, shipDestroyed, shipId))
+            return false;
+    }
     return true;
 }
 
@@ -388,7 +545,37 @@ bool Board::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
     return m_impl->attack(p, shotHit, shipDestroyed, shipId);
 }
 
+int Board::attackMany(const Point* shots, int nShots, AttackResult* results)
+{
+    return m_impl->attackMany(shots, nShots, results);
+}
+
 bool Board::allShipsDestroyed() const
 {
     return m_impl->allShipsDestroyed();
 }
+
+int Board::nShipsAfloat() const
+{
+    return m_impl->nShipsAfloat();
+}
+
+bool Board::shipPosition(int shipId, Point& topOrLeft, Direction& dir) const
+{
+    return m_impl->shipPosition(shipId, topOrLeft, dir);
+}
+
+bool Board::placeLayout(const vector<string>& rows)
+{
+    return m_impl->placeLayout(rows);
+}
+
+void Board::save(ostream& out) const
+{
+    m_impl->save(out);
+}
+
+bool Board::load(istream& in)
+{
+    return m_impl->load(in);
+}
@@ -2,10 +2,23 @@
 #define BOARD_INCLUDED
 
 #include "globals.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
 
 class Game;
 class BoardImpl;
 
+  // Outcome of one shot, as reported by Board::attack
+struct AttackResult
+{
+    Point p;
+    bool valid;
+    bool shotHit;
+    bool shipDestroyed;
+    int shipId;
+};
+
 class Board
 {
   public:
@@ -18,7 +31,17 @@ class Board
     bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
     void display(bool shotsOnly) const;
     bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+    int attackMany(const Point* shots, int nShots, AttackResult* results);
     bool allShipsDestroyed() const;
+    int nShipsAfloat() const;
+    bool shipPosition(int shipId, Point& topOrLeft, Direction& dir) const;
+      // Places every ship of the game where its symbol appears in a
+      // layout of one string per row ('.' for water); false, with
+      // nothing placed, unless each ship is one line of its length
+    bool placeLayout(const std::vector<std::string>& rows);
+      // Text form of the placed ships and the shots taken, on one line
+    void save(std::ostream& out) const;
+    bool load(std::istream& in);
       // We prevent a Board object from being copied or assigned
     Board(const Board&) = delete;
     Board& operator=(const Board&) = delete;
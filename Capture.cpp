@@ -0,0 +1,389 @@
+#include "Capture.h"
+#include "utility.h"
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+atomic<bool> g_capturing(false);
+
+namespace {
+
+  // Where each array's values sit in a record
+struct CaptureArray
+{
+    const char* name;
+    int offset;
+    int count;
+    const char* shapeTail;  // dimensions after the move count
+};
+
+const int NFIELDS = 9;
+const CaptureArray ARRAYS[] = {
+    { "density", 0,                   MAXCELLS, nullptr },
+    { "player",  MAXCELLS,            1, "" },
+    { "move",    MAXCELLS + 1,        1, "" },
+    { "mode",    MAXCELLS + 2,        1, "" },
+    { "shot",    MAXCELLS + 3,        2, ", 2" },
+    { "size",    MAXCELLS + 5,        2, ", 2" },
+    { "result",  MAXCELLS + 7,        1, "" },
+    { "ship",    MAXCELLS + 8,        1, "" },
+};
+const int NARRAYS = sizeof(ARRAYS) / sizeof(ARRAYS[0]);
+
+struct CaptureRecord
+{
+    int32_t values[MAXCELLS + NFIELDS];
+};
+
+  // Every array together stays under 4 GB, so the .npz needs no zip64
+const uint64_t MAX_MOVES = 0xF0000000u / sizeof(CaptureRecord);
+
+  // Room for the largest header; npy wants data aligned to 64
+const int NPY_HEADER = 128;
+
+typedef ThreadRings<CaptureRecord, 1 << 12> CaptureRings;
+
+mutex g_lock;
+condition_variable g_wake;
+ofstream g_files[NARRAYS];
+string g_path;
+thread g_flusher;
+bool g_running = false;
+bool g_stopping = false;
+uint64_t g_moves = 0;
+atomic<uint64_t> g_dropped(0);
+atomic<unsigned> g_nextId(1);
+atomic<unsigned> g_run(0);
+
+  // The move the calling thread has staged in its ring
+struct Staged
+{
+    unsigned player = 0;  // 0 if none
+    unsigned run = 0;     // capture run it was staged in
+};
+
+thread_local Staged t_staged;
+
+string arrayPath(int a)
+{
+    return g_path + "." + ARRAYS[a].name + ".npy";
+}
+
+bool packing()
+{
+    return g_path.size() > 4 && g_path.compare(g_path.size() - 4, 4, ".npz") == 0;
+}
+
+//####################
+// Writes an npy version 1.0 header for n moves,
+// padded to NPY_HEADER bytes
+//####################
+void writeNpyHeader(ostream& out, int a, uint64_t n)
+{
+    ostringstream dict;
+    dict << "{'descr': '<i4', 'fortran_order': False, 'shape': (" << n;
+    if (ARRAYS[a].shapeTail == nullptr)
+        dict << ", " << MAXROWS << ", " << MAXCOLS;
+    else
+        dict << (*ARRAYS[a].shapeTail == '\0' ? "," : ARRAYS[a].shapeTail);
+    dict << "), }";
+    string header = dict.str();
+    header.resize(NPY_HEADER - 10 - 1, ' ');
+    header += '\n';
+
+    int len = static_cast<int>(header.size());
+    out.write("\x93NUMPY\x01\x00", 8);
+    out.put(static_cast<char>(len & 0xFF));
+    out.put(static_cast<char>(len >> 8));
+    out << header;
+}
+
+//####################
+// Appends every staged-and-finished move to the array files
+// Caller holds g_lock
+//####################
+void drainLocked()
+{
+    CaptureRings::drain([](int, const CaptureRecord& rec)
+    {
+        if (g_moves >= MAX_MOVES)
+        {
+            g_dropped.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+        for (int a = 0; a < NARRAYS; a++)
+            g_files[a].write(reinterpret_cast<const char*>(rec.values + ARRAYS[a].offset),
+                             ARRAYS[a].count * sizeof(int32_t));
+        g_moves++;
+    });
+}
+
+void flushLoop()
+{
+    unique_lock<mutex> lock(g_lock);
+    while (!g_stopping)
+    {
+        g_wake.wait_for(lock, chrono::milliseconds(20));
+        drainLocked();
+    }
+}
+
+uint32_t crc32(uint32_t crc, const char* data, size_t n)
+{
+    static uint32_t table[256];
+    static bool made = false;
+    if (!made)
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        made = true;
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < n; i++)
+        crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void putU16(ostream& out, unsigned v)
+{
+    out.put(static_cast<char>(v & 0xFF));
+    out.put(static_cast<char>((v >> 8) & 0xFF));
+}
+
+void putU32(ostream& out, uint32_t v)
+{
+    putU16(out, v & 0xFFFF);
+    putU16(out, v >> 16);
+}
+
+//####################
+// Packs the array files into an uncompressed zip, the form
+// np.load reads as an .npz, and removes them
+// Returns false if the archive can't be written
+//####################
+bool packArrays()
+{
+    ofstream zip(g_path, ios::binary | ios::trunc);
+    if (!zip)
+        return false;
+
+    struct Entry
+    {
+        string name;
+        uint32_t crc;
+        uint32_t size;
+        uint32_t offset;
+    };
+    vector<Entry> entries;
+    vector<char> chunk(1 << 20);
+    for (int a = 0; a < NARRAYS; a++)
+    {
+        Entry e = { string(ARRAYS[a].name) + ".npy", 0, 0, static_cast<uint32_t>(zip.tellp()) };
+
+        // Local header, with the crc and sizes filled in after the data
+        putU32(zip, 0x04034B50);
+        putU16(zip, 20);
+        putU16(zip, 0);
+        putU16(zip, 0);
+        putU16(zip, 0);
+        putU16(zip, 0x21);
+        putU32(zip, 0);
+        putU32(zip, 0);
+        putU32(zip, 0);
+        putU16(zip, static_cast<unsigned>(e.name.size()));
+        putU16(zip, 0);
+        zip << e.name;
+
+        ifstream in(arrayPath(a), ios::binary);
+        while (in)
+        {
+            in.read(chunk.data(), chunk.size());
+            size_t n = in.gcount();
+            e.crc = crc32(e.crc, chunk.data(), n);
+            e.size += static_cast<uint32_t>(n);
+            zip.write(chunk.data(), n);
+        }
+        in.close();
+        remove(arrayPath(a).c_str());
+
+        streampos end = zip.tellp();
+        zip.seekp(e.offset + 14);
+        putU32(zip, e.crc);
+        putU32(zip, e.size);
+        putU32(zip, e.size);
+        zip.seekp(end);
+        entries.push_back(e);
+    }
+
+    uint32_t directory = static_cast<uint32_t>(zip.tellp());
+    for (const Entry& e : entries)
+    {
+        putU32(zip, 0x02014B50);
+        putU16(zip, 20);
+        putU16(zip, 20);
+        putU16(zip, 0);
+        putU16(zip, 0);
+        putU16(zip, 0);
+        putU16(zip, 0x21);
+        putU32(zip, e.crc);
+        putU32(zip, e.size);
+        putU32(zip, e.size);
+        putU16(zip, static_cast<unsigned>(e.name.size()));
+        putU16(zip, 0);
+        putU16(zip, 0);
+        putU16(zip, 0);
+        putU16(zip, 0);
+        putU32(zip, 0);
+        putU32(zip, e.offset);
+        zip << e.name;
+    }
+    uint32_t directorySize = static_cast<uint32_t>(zip.tellp()) - directory;
+    putU32(zip, 0x06054B50);
+    putU16(zip, 0);
+    putU16(zip, 0);
+    putU16(zip, NARRAYS);
+    putU16(zip, NARRAYS);
+    putU32(zip, directorySize);
+    putU32(zip, directory);
+    putU16(zip, 0);
+    return static_cast<bool>(zip);
+}
+
+}  // namespace
+
+unsigned newCaptureId()
+{
+    return g_nextId.fetch_add(1, memory_order_relaxed);
+}
+
+//####################
+// Copies a move into the next free slot of the calling
+// thread's ring, without publishing it yet
+//####################
+void captureChoice(unsigned player, int move, int mode, const int* density,
+                   Point shot, int rows, int cols)
+{
+    CaptureRecord* rec = CaptureRings::reserve();
+    if (rec == nullptr)
+    {
+        g_dropped.fetch_add(1, memory_order_relaxed);
+        t_staged.player = 0;
+        return;
+    }
+    int32_t* v = rec->values;
+    memcpy(v, density, MAXCELLS * sizeof(int32_t));
+    int32_t fields[] = { static_cast<int32_t>(player), move, mode, shot.r, shot.c, rows, cols };
+    memcpy(v + MAXCELLS, fields, sizeof(fields));
+    t_staged.player = player;
+    t_staged.run = g_run.load(memory_order_relaxed);
+}
+
+//####################
+// Adds the result to the staged move and publishes it
+//####################
+void captureResult(unsigned player, bool validShot, bool shotHit,
+                   bool shipDestroyed, int shipId)
+{
+    if (t_staged.player != player || player == 0 ||
+        t_staged.run != g_run.load(memory_order_relaxed))
+        return;
+    t_staged.player = 0;
+
+    // Still the staged slot: only publishing moves past it
+    int32_t* v = CaptureRings::reserve()->values;
+    v[MAXCELLS + 7] = !validShot ? -1 : shipDestroyed ? 2 : shotHit ? 1 : 0;
+    v[MAXCELLS + 8] = validShot && shipDestroyed ? shipId : -1;
+    CaptureRings::publish();
+}
+
+static_assert(sizeof(int) == sizeof(int32_t), "density maps are copied as int32");
+
+//####################
+// Opens the array files and starts capturing moves
+// Returns false if already capturing or a file can't be written
+//####################
+bool startCapture(const string& path)
+{
+    lock_guard<mutex> lock(g_lock);
+    if (g_running)
+        return false;
+    g_path = path;
+    for (int a = 0; a < NARRAYS; a++)
+    {
+        g_files[a].open(arrayPath(a), ios::binary | ios::trunc);
+        if (!g_files[a])
+        {
+            for (int b = 0; b <= a; b++)
+            {
+                g_files[b].close();
+                remove(arrayPath(b).c_str());
+            }
+            return false;
+        }
+        writeNpyHeader(g_files[a], a, 0);
+    }
+
+    // Moves published after the last stop are not part of this capture
+    CaptureRings::discard();
+
+    g_run++;
+    g_moves = 0;
+    g_dropped = 0;
+    g_stopping = false;
+    g_running = true;
+    g_flusher = thread(flushLoop);
+    g_capturing.store(true, memory_order_release);
+    return true;
+}
+
+//####################
+// Stops capturing, writes what is buffered, fixes the
+// array headers and packs them if asked
+//####################
+void stopCapture()
+{
+    {
+        lock_guard<mutex> lock(g_lock);
+        if (!g_running)
+            return;
+        g_capturing.store(false, memory_order_release);
+        g_stopping = true;
+    }
+    g_wake.notify_one();
+    g_flusher.join();
+
+    lock_guard<mutex> lock(g_lock);
+    drainLocked();
+    for (int a = 0; a < NARRAYS; a++)
+    {
+        g_files[a].seekp(0);
+        writeNpyHeader(g_files[a], a, g_moves);
+        g_files[a].close();
+    }
+    if (packing() && !packArrays())
+        remove(g_path.c_str());
+    g_running = false;
+}
+
+uint64_t captureDropped()
+{
+    return g_dropped.load(memory_order_relaxed);
+}
+
+uint64_t capturedMoves()
+{
+    lock_guard<mutex> lock(g_lock);
+    return g_moves;
+}
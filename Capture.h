@@ -0,0 +1,53 @@
+#ifndef CAPTURE_INCLUDED
+#define CAPTURE_INCLUDED
+
+#include "globals.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+  // Opt-in capture of GoodPlayer's density map, shot and result on
+  // every move, written as NumPy arrays for the notebook
+  //
+  // Each thread copies its moves into its own preallocated ring
+  // without locking; a background thread drains the rings into one
+  // .npy file per array. If path ends in .npz the files are packed into
+  // that archive when capture stops (np.load(path)["density"]),
+  // otherwise they are left as path.density.npy, path.shot.npy and so on.
+  // Arrays, one entry per move:
+  //   density  int32 (n, MAXROWS, MAXCOLS)  map the shot was chosen from
+  //   player   int32 (n)  capture id of the player, unique per process
+  //   move     int32 (n)  shots the player had resolved before this one
+  //   mode     int32 (n)  0 hunting, 1 targeting
+  //   shot     int32 (n, 2)  row and column fired at
+  //   size     int32 (n, 2)  board rows and columns
+  //   result   int32 (n)  -1 invalid, 0 miss, 1 hit, 2 sunk
+  //   ship     int32 (n)  id of the ship sunk, or -1
+  // A move that finds its ring full is dropped and counted, as are
+  // moves once the arrays would pass 4 GB.
+bool startCapture(const std::string& path);
+void stopCapture();
+std::uint64_t captureDropped();
+std::uint64_t capturedMoves();
+
+  // Set only between startCapture and stopCapture
+extern std::atomic<bool> g_capturing;
+
+inline bool capturing()
+{
+    return g_capturing.load(std::memory_order_relaxed);
+}
+
+  // A fresh id for a capturing player
+unsigned newCaptureId();
+
+  // Stages a move in this thread's ring; density is MAXROWS x MAXCOLS
+  // row-major. The move is kept once captureResult reports its result.
+void captureChoice(unsigned player, int move, int mode, const int* density,
+                   Point shot, int rows, int cols);
+
+  // Completes the move player staged on this thread, if any
+void captureResult(unsigned player, bool validShot, bool shotHit,
+                   bool shipDestroyed, int shipId);
+
+#endif // CAPTURE_INCLUDED
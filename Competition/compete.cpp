@@ -1,6 +1,7 @@
 #include "Game.h"
 #include "Player.h"
 #include "Board.h"
+#include "../Sprt.h"
 #include <iostream>
 #include <string>
 
@@ -17,15 +18,20 @@ bool addStandardShips(Game& g)
 
 int main()
 {
-    const int NTRIALS = 10;
+    // Play until an SPRT can tell the players apart (one wins at least
+    // 55% of decisive games, 5% error either way), at most MAXTRIALS
+    const int MAXTRIALS = 2000;
+    Sprt sprt(0.05, 0.05, 0.05);
     string name1 = "BOB";
     string name2 = "MEGAMIND";
     cout << "COMPETITION BETWEEN " << name1 << " AND " << name2 << endl;
     cin.ignore();
     int p1Wins = 0;
     int p2Wins = 0;
+    int nTrials = 0;
+    Sprt::Decision decision = Sprt::CONTINUE;
 
-    for (int k = 1; k <= NTRIALS; k++)
+    for (int k = 1; k <= MAXTRIALS && decision == Sprt::CONTINUE; k++)
     {
         cout << "============================= Game " << k
             << " =============================" << endl;
@@ -41,15 +47,18 @@ int main()
             p2Wins++;
         delete p1;
         delete p2;
+        nTrials = k;
+        decision = sprt.decide(p1Wins, p2Wins);
     }
     
-    if (p1Wins == p2Wins)
-        cout << "DRAW!" << endl;
+    if (decision == Sprt::CONTINUE)
+        cout << "DRAW! (no significant difference)" << endl;
     else
     {
-        string winner = p1Wins > p2Wins ? name1 : name2;
+        string winner = decision == Sprt::FIRST_BETTER ? name1 : name2;
         cout << "WINNER IS " << winner << "!" << endl;
     }
-    cout << name1 << " won " << p1Wins << " out of " << NTRIALS << " games." << endl;
-    cout << name2 << " won " << p2Wins << " out of " << NTRIALS << " games." << endl;
+    cout << name1 << " won " << p1Wins << " out of " << nTrials << " games." << endl;
+    cout << name2 << " won " << p2Wins << " out of " << nTrials << " games." << endl;
+    cout << "A fixed-size match would need " << sprt.fixedGames() << " decisive games." << endl;
 }
\ No newline at end of file
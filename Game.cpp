@@ -3,11 +3,15 @@
 #include "Player.h"
 #include "globals.h"
 #include "utility.h"
+#include "Histogram.h"
+#include "Trace.h"
+#include "GameRecord.h"
 #include <iostream>
 #include <string>
 #include <cstdlib>
 #include <cctype>
 #include <vector>
+#include <chrono>
 
 using namespace std;
 
@@ -24,16 +28,102 @@ class GameImpl
     int shipLength(int shipId) const;
     char shipSymbol(int shipId) const;
     string shipName(int shipId) const;
-    Player* play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause);
+    const Fleet& fleet() const;
+    void setSalvo(int shotsPerTurn, bool oneShotPerShip);
+    void setTimeControl(double moveLimitMs, double gameLimitMs, TimeoutPolicy policy);
+    void setVerbose(bool verbose);
+    bool outOfTime() const;
+    PlayerClock playerClock(const Player* p) const;
+    void setLatencyTable(const Player* p, LatencyTable* table);
+    void setCalibrationTable(const Player* p, CalibrationTable* table);
+    void setSeed(unsigned seed);
+    void setRecordWriter(RecordWriter* writer);
+    const GameRecord& lastRecord() const;
+    Player* play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause, istream* state, bool& loaded);
+    void setCheckpoint(double everyMs, function<void()> save);
+    bool saveState(ostream& out) const;
 
 private:
-    bool playerAttack(Player* attacker, Player* attacked, Board& attackedBoard, bool shouldPause);
+    bool loadState(istream& in);
+    Player* playTurns(bool shouldPause, bool resumed);
+    Player* playerAttack(int attacker, Board& attackerBoard, Board& attackedBoard, bool shouldPause);
+    bool salvoAttack(int attacker, Board& attackerBoard, Board& attackedBoard);
+    template <typename Call>
+    bool timed(int who, CallKind kind, Call call);
+    template <typename Call>
+    bool notify(int who, CallKind kind, Call call);
+    GamePhase phase(int who) const;
+    int tableSlot(const Player* p);
+    void recordShot(int who, Point p, bool valid, bool shotHit, bool shipDestroyed, int shipId);
+    bool onAutopilot(int who) const;
+    bool randomPlacement(Board& b);
+    ostream& out();
 
     int m_rows;
     int m_cols;
 
+    // Players of the current game, in turn order, and their boards
+    Player* m_players[2];
+    Board* m_boards[2];
+
+    // Player to attack next
+    int m_turn;
+
+    // Time spent by each player in the current game
+    PlayerClock m_clocks[2];
+
+    // Where to record each player's call latencies and
+    // shot calibration (optional), by owner, and for the
+    // players of the current game
+    const Player* m_tableOwners[2];
+    LatencyTable* m_latencyTables[2];
+    CalibrationTable* m_calibrationTables[2];
+    LatencyTable* m_tables[2];
+    CalibrationTable* m_calibration[2];
+
+    // Shots fired by each player, and hits on ships still afloat
+    int m_shots[2];
+    int m_openHits[2];
+
+    // Limits per call and per game in ms (0 means unlimited)
+    double m_moveLimitMs;
+    double m_gameLimitMs;
+    TimeoutPolicy m_policy;
+
+    // Player who forfeited on time, or -1
+    int m_forfeiter;
+
+    // Deadline of the call in progress, if it has one
+    bool m_hasDeadline;
+    chrono::steady_clock::time_point m_deadline;
+
+    // Print turns and boards during play
+    bool m_verbose;
+
+    // Shots fired per turn (1 is the classic game)
+    int m_shotsPerTurn;
+
+    // Salvo fires one shot per ship the attacker has afloat
+    bool m_oneShotPerShip;
+
+    // Seed for the random numbers of each game, if set
+    bool m_seeded;
+    unsigned m_seed;
+
+    // Where to save a record of each game (optional)
+    RecordWriter* m_writer;
+    GameRecord m_record;
+
+    // Called between turns at most every m_checkpointMs (optional)
+    function<void()> m_checkpoint;
+    double m_checkpointMs;
+    Timer m_sinceCheckpoint;
+
     // Stores available ShipTypes for the game
     vector<ShipType> shipTypes;
+
+    // Flattened copy of shipTypes for hot paths
+    Fleet m_fleet;
 };
 
 void waitForEnter()
@@ -42,7 +132,15 @@ void waitForEnter()
     cin.ignore(10000, '\n');
 }
 
-GameImpl::GameImpl(int nRows, int nCols): m_rows(nRows), m_cols(nCols) { }
+GameImpl::GameImpl(int nRows, int nCols)
+ : m_rows(nRows), m_cols(nCols), m_players{ nullptr, nullptr }, m_boards{ nullptr, nullptr },
+   m_turn(0), m_clocks{},
+   m_tableOwners{ nullptr, nullptr }, m_latencyTables{ nullptr, nullptr },
+   m_calibrationTables{ nullptr, nullptr }, m_tables{ nullptr, nullptr },
+   m_calibration{ nullptr, nullptr }, m_shots{ 0, 0 }, m_openHits{ 0, 0 },
+   m_moveLimitMs(0), m_gameLimitMs(0), m_policy(FORFEIT), m_forfeiter(-1), m_hasDeadline(false),
+   m_verbose(true), m_shotsPerTurn(1), m_oneShotPerShip(false),
+   m_seeded(false), m_seed(0), m_writer(nullptr), m_checkpointMs(0) { }
 
 int GameImpl::rows() const
 {
@@ -82,22 +180,27 @@ bool GameImpl::addShip(int length, char symbol, string name)
     }
 
     shipTypes.push_back(ShipType(length, symbol, name));
+    m_fleet.add(length, symbol, shipTypes.back().name);
+
+    // Growing shipTypes may have moved every name
+    for (int s = 0; s < m_fleet.nShips; s++)
+        m_fleet.rename(s, shipTypes[s].name);
     return true;
 }
 
 int GameImpl::nShips() const
 {
-    return shipTypes.size();
+    return m_fleet.nShips;
 }
 
 int GameImpl::shipLength(int shipId) const
 {
-    return shipTypes[shipId].length;
+    return m_fleet.lengths[shipId];
 }
 
 char GameImpl::shipSymbol(int shipId) const
 {
-    return shipTypes[shipId].symbol;
+    return m_fleet.symbols[shipId];
 }
 
 string GameImpl::shipName(int shipId) const
@@ -105,6 +208,366 @@ string GameImpl::shipName(int shipId) const
     return shipTypes[shipId].name;
 }
 
+const Fleet& GameImpl::fleet() const
+{
+    return m_fleet;
+}
+
+void GameImpl::setSalvo(int shotsPerTurn, bool oneShotPerShip)
+{
+    m_shotsPerTurn = shotsPerTurn;
+    m_oneShotPerShip = oneShotPerShip;
+}
+
+void GameImpl::setTimeControl(double moveLimitMs, double gameLimitMs, TimeoutPolicy policy)
+{
+    m_moveLimitMs = moveLimitMs;
+    m_gameLimitMs = gameLimitMs;
+    m_policy = policy;
+}
+
+void GameImpl::setVerbose(bool verbose)
+{
+    m_verbose = verbose;
+}
+
+bool GameImpl::outOfTime() const
+{
+    return m_hasDeadline && chrono::steady_clock::now() > m_deadline;
+}
+
+PlayerClock GameImpl::playerClock(const Player* p) const
+{
+    for (int who = 0; who < 2; who++)
+        if (m_players[who] == p)
+            return m_clocks[who];
+    return PlayerClock{};
+}
+
+// ##########################
+// Stream for play-by-play output
+// (discards everything when not verbose)
+// ##########################
+ostream& GameImpl::out()
+{
+    static thread_local ostream discard(nullptr);
+    return m_verbose ? cout : discard;
+}
+
+// ##########################
+// Records a player's latencies into a table
+// (one per strategy, say) during play
+// ##########################
+void GameImpl::setLatencyTable(const Player* p, LatencyTable* table)
+{
+    m_latencyTables[tableSlot(p)] = table;
+}
+
+// ##########################
+// Records how well a player's own hit probabilities
+// predict its shots into a table during play
+// ##########################
+void GameImpl::setCalibrationTable(const Player* p, CalibrationTable* table)
+{
+    m_calibrationTables[tableSlot(p)] = table;
+}
+
+// ##########################
+// Slot of p's tables: its existing one, else a free one,
+// else the second, whose tables are then dropped
+// ##########################
+int GameImpl::tableSlot(const Player* p)
+{
+    int slot = m_tableOwners[0] == p || m_tableOwners[0] == nullptr ? 0 : 1;
+    if (m_tableOwners[slot] != p)
+    {
+        m_tableOwners[slot] = p;
+        m_latencyTables[slot] = nullptr;
+        m_calibrationTables[slot] = nullptr;
+    }
+    return slot;
+}
+
+// ##########################
+// Every game starts from this seed, so it can be replayed
+// ##########################
+void GameImpl::setSeed(unsigned seed)
+{
+    m_seeded = true;
+    m_seed = seed;
+}
+
+void GameImpl::setRecordWriter(RecordWriter* writer)
+{
+    m_writer = writer;
+}
+
+const GameRecord& GameImpl::lastRecord() const
+{
+    return m_record;
+}
+
+void GameImpl::setCheckpoint(double everyMs, function<void()> save)
+{
+    m_checkpointMs = everyMs;
+    m_checkpoint = save;
+}
+
+// ##########################
+// Writes the game in progress on one line: the turn,
+// each player's counters, clock, board and strategy
+// state, the shots recorded and the random numbers
+// 
+// Only meaningful between turns, as from a checkpoint
+// ##########################
+bool GameImpl::saveState(ostream& out) const
+{
+    if (m_boards[0] == nullptr || m_boards[1] == nullptr)
+        return false;
+    streamsize precision = out.precision(17);
+    out << "BSGAME 2 " << m_turn;
+    for (int who = 0; who < 2; who++)
+    {
+        const PlayerClock& clock = m_clocks[who];
+        out << ' ' << m_shots[who] << ' ' << m_openHits[who] << ' ' << clock.usedMs << ' '
+            << clock.maxCallMs << ' ' << clock.calls << ' ' << clock.timeouts << ' ' << clock.heap.allocs << ' '
+            << clock.heap.bytes << ' ' << clock.heap.liveBytes << ' ' << clock.heap.peakBytes << ' ';
+        m_boards[who]->save(out);
+        out << ' ';
+        m_players[who]->saveState(out);
+    }
+    out << ' ' << m_record.shots.size();
+    for (const GameRecord::Shot& shot : m_record.shots)
+        out << ' ' << shot.who << ' ' << shot.p.r << ' ' << shot.p.c << ' ' << shot.valid << ' '
+            << shot.shotHit << ' ' << shot.shipDestroyed << ' ' << shot.shipId;
+    out << ' ' << randomGenerator();
+    out.precision(precision);
+    return static_cast<bool>(out);
+}
+
+// ##########################
+// Reads what saveState wrote into the game being set up
+// Returns false if it is malformed or doesn't fit
+// ##########################
+bool GameImpl::loadState(istream& in)
+{
+    string magic;
+    int version;
+    if (!(in >> magic >> version >> m_turn) || magic != "BSGAME" || version != 2 || (m_turn != 0 && m_turn != 1))
+        return false;
+    for (int who = 0; who < 2; who++)
+    {
+        PlayerClock& clock = m_clocks[who];
+        if (!(in >> m_shots[who] >> m_openHits[who] >> clock.usedMs >> clock.maxCallMs >> clock.calls >> clock.timeouts
+                 >> clock.heap.allocs >> clock.heap.bytes >> clock.heap.liveBytes >> clock.heap.peakBytes) ||
+            !m_boards[who]->load(in) || !m_players[who]->loadState(in))
+            return false;
+    }
+    size_t nShots;
+    if (!(in >> nShots))
+        return false;
+    for (size_t n = 0; n < nShots; n++)
+    {
+        GameRecord::Shot shot;
+        if (!(in >> shot.who >> shot.p.r >> shot.p.c >> shot.valid >> shot.shotHit
+                 >> shot.shipDestroyed >> shot.shipId))
+            return false;
+        m_record.shots.push_back(shot);
+    }
+    if (!(in >> randomGenerator()))
+        return false;
+
+    for (int who = 0; who < 2; who++)
+        for (int shipId = 0; shipId < nShips(); shipId++)
+        {
+            GameRecord::Placement pl;
+            if (!m_boards[who]->shipPosition(shipId, pl.topOrLeft, pl.dir))
+                return false;
+            m_record.placements[who].push_back(pl);
+        }
+    return true;
+}
+
+// ##########################
+// The attacker's phase, judged from its own shots
+// ##########################
+GamePhase GameImpl::phase(int who) const
+{
+    if (m_openHits[who] > 0)
+        return TARGET_MODE;
+    return m_shots[who] < 20 ? EARLY_HUNT : MID_GAME;
+}
+
+// ##########################
+// Tracks a shot's effect on the attacker's phase,
+// and adds it to the game record
+// ##########################
+void GameImpl::recordShot(int who, Point p, bool valid, bool shotHit, bool shipDestroyed, int shipId)
+{
+    m_record.shots.push_back(GameRecord::Shot{ who, p, valid, shotHit, shipDestroyed, shipId });
+
+    m_shots[who]++;
+    if (shotHit)
+        m_openHits[who]++;
+    if (shipDestroyed)
+        m_openHits[who] -= m_fleet.lengths[shipId];
+}
+
+// ##########################
+// Runs one player call on that player's clock
+// 
+// The call may poll Game::outOfTime to stop early
+// Returns false if it overran its move or game limit
+// ##########################
+template <typename Call>
+bool GameImpl::timed(int who, CallKind kind, Call call)
+{
+    PlayerClock& clock = m_clocks[who];
+    GamePhase callPhase = phase(who);
+
+    // Budget is the tighter of the move limit and what is left of the game limit
+    double budget = m_moveLimitMs;
+    if (m_gameLimitMs > 0 && (budget <= 0 || m_gameLimitMs - clock.usedMs < budget))
+        budget = m_gameLimitMs - clock.usedMs;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    m_hasDeadline = budget > 0;
+    if (m_hasDeadline)
+        m_deadline = start +
+            chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double, milli>(budget));
+
+    {
+        TraceScope span(CALL_NAMES[kind]);
+        HeapCharge charge(&clock.heap);
+        call();
+    }
+    long long ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    double ms = ns / 1e6;
+    m_hasDeadline = false;
+
+    if (LATENCY_HISTOGRAMS && m_tables[who] != nullptr)
+        m_tables[who]->histograms[kind][callPhase].record(ns);
+
+    clock.usedMs += ms;
+    if (ms > clock.maxCallMs)
+        clock.maxCallMs = ms;
+    clock.calls++;
+    if (budget > 0 && ms > budget)
+    {
+        clock.timeouts++;
+        return false;
+    }
+    return true;
+}
+
+// ##########################
+// A player whose game clock has run out under RANDOM_MOVE
+// is no longer consulted; the game fires for it at random
+// ##########################
+bool GameImpl::onAutopilot(int who) const
+{
+    return m_gameLimitMs > 0 && m_clocks[who].usedMs >= m_gameLimitMs;
+}
+
+// ##########################
+// Fallback placement for a player out of time:
+// random positions, restarting after too many misses
+// ##########################
+bool GameImpl::randomPlacement(Board& b)
+{
+    for (int attempt = 0; attempt < 100; attempt++)
+    {
+        int shipId = 0;
+        for (int tries = 0; shipId < nShips() && tries < 100; tries++)
+        {
+            Direction dir = randInt(2) == 0 ? HORIZONTAL : VERTICAL;
+            if (b.placeShip(randomPoint(), shipId, dir))
+                shipId++;
+        }
+        if (shipId == nShips())
+            return true;
+        b.clear();
+    }
+    return false;
+}
+
+// ##########################
+// Runs a player call that is not a move choice
+// 
+// Skipped for players on autopilot; a timeout
+// only matters under FORFEIT
+// Returns false if the player forfeits
+// ##########################
+template <typename Call>
+bool GameImpl::notify(int who, CallKind kind, Call call)
+{
+    if (onAutopilot(who) || timed(who, kind, call) || m_policy != FORFEIT)
+        return true;
+    m_forfeiter = who;
+    return false;
+}
+
+// ##########################
+// Salvo turn: the attacker fires several shots at once
+// 
+// All shots are resolved by the board in one batch,
+// then reported to both players in firing order
+// Returns false if a player forfeits on time
+// ##########################
+bool GameImpl::salvoAttack(int who, Board& attackerBoard, Board& attackedBoard)
+{
+    Player* attacker = m_players[who];
+    Player* attacked = m_players[1 - who];
+    Point shots[MAXCELLS];
+    int scores[MAXCELLS];
+    AttackResult results[MAXCELLS];
+
+    int k = m_oneShotPerShip ? attackerBoard.nShipsAfloat() : m_shotsPerTurn;
+    if (k > MAXCELLS)
+        k = MAXCELLS;
+
+    // Ask for the salvo, firing at random if the attacker runs out of time
+    int nShots = 0;
+    if (onAutopilot(who) || !timed(who, RECOMMEND_ATTACK, [&] { nShots = attacker->recommendAttacks(shots, scores, k); }))
+    {
+        if (m_policy == FORFEIT && !onAutopilot(who))
+        {
+            m_forfeiter = who;
+            return false;
+        }
+        out() << attacker->name() << " is out of time and fires at random." << endl;
+        for (nShots = 0; nShots < k; nShots++)
+            shots[nShots] = randomPoint();
+    }
+    attackedBoard.attackMany(shots, nShots, results);
+    for (int n = 0; n < nShots; n++)
+        recordShot(who, results[n].p, results[n].valid, results[n].shotHit, results[n].shipDestroyed, results[n].shipId);
+
+    out() << attacker->name() << " fires a salvo of " << nShots << ":" << endl;
+    for (int n = 0; n < nShots; n++)
+    {
+        const AttackResult& res = results[n];
+        if (!notify(who, RECORD_RESULT, [&] { attacker->recordAttackResult(res.p, res.valid, res.shotHit, res.shipDestroyed, res.shipId); }) ||
+            !notify(1 - who, RECORD_OPPONENT, [&] { attacked->recordAttackByOpponent(res.p); }))
+            return false;
+
+        out() << "  (" << res.p.r << "," << res.p.c << ") ";
+        if (!res.valid)
+            out() << "wasted";
+        else if (res.shipDestroyed)
+            out() << "destroyed the " << shipName(res.shipId);
+        else if (res.shotHit)
+            out() << "hit something";
+        else
+            out() << "missed";
+        out() << endl;
+    }
+    out() << "resulting in:" << endl;
+    if (m_verbose)
+        attackedBoard.display(attacker->isHuman());
+    return true;
+}
+
 // ##########################
 // One player attacks the other's board
 // 
@@ -116,64 +579,109 @@ string GameImpl::shipName(int shipId) const
 // 6. Displays attack result on board
 // 7. Checks if game is over (all ships destroyed)
 // 8. Pauses for enter (or not)
+// 
+// Returns the winner if the game is over, otherwise nullptr
 // ##########################
-bool GameImpl::playerAttack(Player* attacker, Player* attacked, Board& attackedBoard, bool shouldPause)
+Player* GameImpl::playerAttack(int who, Board& attackerBoard, Board& attackedBoard, bool shouldPause)
 {
+    Player* attacker = m_players[who];
+    Player* attacked = m_players[1 - who];
+
     //// 1. Prompts attacker's turn, displays other's board
-    cout << attacker->name() << "'s turn.   Board for " << attacked->name() << ":" << endl;
+    out() << attacker->name() << "'s turn.   Board for " << attacked->name() << ":" << endl;
     // Display shots only if attacker is a HumanPlayer
-    attackedBoard.display(attacker->isHuman());
+    if (m_verbose)
+        attackedBoard.display(attacker->isHuman());
+
+    // Salvo variant replaces steps 2 - 6
+    if (m_shotsPerTurn != 1 || m_oneShotPerShip)
+    {
+        if (!salvoAttack(who, attackerBoard, attackedBoard))
+        {
+            out() << m_players[m_forfeiter]->name() << " ran out of time." << endl;
+            return m_players[1 - m_forfeiter];
+        }
+        if (attackedBoard.allShipsDestroyed())
+            return attacker;
+        if (shouldPause)
+            waitForEnter();
+        return nullptr;
+    }
 
     // 2. Gets recommended point from attacker
-    Point attackPos = attacker->recommendAttack();
+    //    (or a random one if the attacker runs out of time),
+    //    and the attacker's odds of a hit if calibrating
+    Point attackPos;
+    double predicted = -1;
+    if (onAutopilot(who) || !timed(who, RECOMMEND_ATTACK, [&] { attackPos = attacker->recommendAttack(); }))
+    {
+        if (m_policy == FORFEIT && !onAutopilot(who))
+        {
+            out() << attacker->name() << " ran out of time." << endl;
+            return attacked;
+        }
+        out() << attacker->name() << " is out of time and fires at random." << endl;
+        attackPos = randomPoint();
+    }
+    else if (m_calibration[who] != nullptr)
+        predicted = attacker->hitProbability();
     bool shotHit;
     bool shipDestroyed;
     int shipIdAttacked;
 
     // 3. Attack other's board at recommended point
+    GamePhase shotPhase = phase(who);
     bool boardAttack = attackedBoard.attack(attackPos, shotHit, shipDestroyed, shipIdAttacked);
+    recordShot(who, attackPos, boardAttack, shotHit, shipDestroyed, shipIdAttacked);
+    if (predicted >= 0 && boardAttack)
+        m_calibration[who]->phases[shotPhase].record(predicted, shotHit);
 
     // 4, 5. Record attack result with attacker and attacked
-    attacker->recordAttackResult(attackPos, boardAttack, shotHit, shipDestroyed, shipIdAttacked);
-    attacked->recordAttackByOpponent(attackPos);
+    if (!notify(who, RECORD_RESULT, [&] { attacker->recordAttackResult(attackPos, boardAttack, shotHit, shipDestroyed, shipIdAttacked); }) ||
+        !notify(1 - who, RECORD_OPPONENT, [&] { attacked->recordAttackByOpponent(attackPos); }))
+    {
+        out() << m_players[m_forfeiter]->name() << " ran out of time." << endl;
+        return m_players[1 - m_forfeiter];
+    }
 
     // 6. Display attack result on board
     if (boardAttack)
     {
         // Display attack position
-        cout << attacker->name() << " attacked (" << attackPos.r << "," << attackPos.c << ") and ";
+        out() << attacker->name() << " attacked (" << attackPos.r << "," << attackPos.c << ") and ";
 
         // Display valid shot result
         if (shotHit)
         {
             if (shipDestroyed)
-                cout << "destroyed the " << shipName(shipIdAttacked);
+                out() << "destroyed the " << shipName(shipIdAttacked);
             else
-                cout << "hit something";
+                out() << "hit something";
         }
         else
-            cout << "missed";
+            out() << "missed";
 
         // Display board after attack
-        cout << ", resulting in:" << endl;
-        attackedBoard.display(attacker->isHuman());
+        out() << ", resulting in:" << endl;
+        if (m_verbose)
+            attackedBoard.display(attacker->isHuman());
     }
     // Invalid point (out of bounds or same as previous attack)
     else
     {
-        cout << attacker->name() << " wasted a shot at (" << attackPos.r << "," << attackPos.c << ")." << endl;
+        out() << attacker->name() << " wasted a shot at (" << attackPos.r << "," << attackPos.c << ")." << endl;
     }
 
     // 7. Check if game is over (all ships destroyed)
     if (attackedBoard.allShipsDestroyed())
-        return true;
+        return attacker;
 
     // 8. Pause (or not)
     if (shouldPause)
         waitForEnter();
 
     // Game is not over yet
-    return false;
+    return nullptr;
 }
 
 // ######################
@@ -182,26 +690,125 @@ bool GameImpl::playerAttack(Player* attacker, Player* attacked, Board& attackedB
 // 1. Places ships for both players
 // 2. Players attack in order until one wins
 // ######################
-Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause)
+Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause,
+                       istream* state, bool& loaded)
 {
-    // If cannot place ships for either player
-    if (!p1->placeShips(b1) || !p2->placeShips(b2))
+    TraceScope span("game");
+    m_players[0] = p1;
+    m_players[1] = p2;
+    m_boards[0] = &b1;
+    m_boards[1] = &b2;
+    m_turn = 0;
+    m_clocks[0] = m_clocks[1] = PlayerClock{};
+    for (int who = 0; who < 2; who++)
+    {
+        m_shots[who] = m_openHits[who] = 0;
+        m_tables[who] = nullptr;
+        m_calibration[who] = nullptr;
+        for (int slot = 0; slot < 2; slot++)
+            if (m_tableOwners[slot] == m_players[who])
+            {
+                m_tables[who] = m_latencyTables[slot];
+                m_calibration[who] = m_calibrationTables[slot];
+            }
+    }
+    m_forfeiter = -1;
+
+    if (m_seeded)
+        seedRandom(m_seed);
+
+    // Record the game, kept for lastRecord() and any RecordWriter
+    m_record.clear();
+    m_record.rows = m_rows;
+    m_record.cols = m_cols;
+    m_record.seeded = m_seeded;
+    m_record.seed = m_seed;
+    m_record.shotsPerTurn = m_oneShotPerShip ? 0 : m_shotsPerTurn;
+    m_record.ships = shipTypes;
+    for (int who = 0; who < 2; who++)
+        m_record.names[who] = m_players[who]->name();
+
+    // A saved game carries on from its last turn
+    loaded = state == nullptr || loadState(*state);
+    if (!loaded)
+    {
+        m_boards[0] = m_boards[1] = nullptr;
         return nullptr;
+    }
+
+    // Reading the thread CPU clock costs a system call, too much to
+    // do around every call; instead each player's in-call time is
+    // scaled by the share of the game the thread spent on a CPU
+    double cpuStart = threadCpuMs();
+    Timer wall;
+    m_sinceCheckpoint.start();
+    Player* winner = playTurns(shouldPause, state != nullptr);
+    double wallMs = wall.elapsed();
+    double onCpu = wallMs > 0 ? (threadCpuMs() - cpuStart) / wallMs : 1;
+    if (onCpu > 1)
+        onCpu = 1;
+    for (int who = 0; who < 2; who++)
+        m_clocks[who].cpuMs = m_clocks[who].usedMs * onCpu;
+
+    m_record.winner = winner == nullptr ? -1 : (winner == m_players[0] ? 0 : 1);
+    if (m_writer != nullptr)
+        m_writer->write(m_record);
+    m_boards[0] = m_boards[1] = nullptr;
+    return winner;
+}
+
+// ######################
+// Places ships for both players, then
+// takes turns until one wins
+// 
+// A resumed game already has its ships placed
+// ######################
+Player* GameImpl::playTurns(bool shouldPause, bool resumed)
+{
+    Board** boards = m_boards;
+
+    // If cannot place ships for either player
+    for (int who = 0; who < 2 && !resumed; who++)
+    {
+        bool placed = false;
+        if (!timed(who, PLACE_SHIPS, [&] { placed = m_players[who]->placeShips(*boards[who]); }))
+        {
+            if (m_policy == FORFEIT)
+            {
+                out() << m_players[who]->name() << " ran out of time placing ships." << endl;
+                return m_players[1 - who];
+            }
+            out() << m_players[who]->name() << " is out of time and ships are placed at random." << endl;
+            boards[who]->clear();
+            placed = randomPlacement(*boards[who]);
+        }
+        if (!placed)
+            return nullptr;
+    }
+
+    for (int who = 0; who < 2 && !resumed; who++)
+        for (int shipId = 0; shipId < nShips(); shipId++)
+        {
+            GameRecord::Placement pl;
+            boards[who]->shipPosition(shipId, pl.topOrLeft, pl.dir);
+            m_record.placements[who].push_back(pl);
+        }
 
     // Loop until a player wins
     while (true)
     {
-        // If player 1 attacks and destroys all ships
-        if (playerAttack(p1, p2, b2, shouldPause))
+        Player* winner = playerAttack(m_turn, *boards[m_turn], *boards[1 - m_turn], shouldPause);
+        if (winner != nullptr)
         {
-            cout << p1->name() << " wins!" << endl;
-            return p1;
+            out() << winner->name() << " wins!" << endl;
+            return winner;
         }
-        // If player 2 attacks and destroys all ships
-        if (playerAttack(p2, p1, b1, shouldPause))
+        m_turn = 1 - m_turn;
+
+        if (m_checkpoint && m_sinceCheckpoint.elapsed() >= m_checkpointMs)
         {
-            cout << p2->name() << " wins!" << endl;
-            return p2;
+            m_checkpoint();
+            m_sinceCheckpoint.start();
         }
     }
 
@@ -279,18 +886,13 @@ bool Game::addShip(int length, char symbol, string name)
              << endl;
         return false;
     }
-    int totalOfLengths = 0;
-    for (int s = 0; s < nShips(); s++)
+    if (fleet().idOf(symbol) != -1)
     {
-        totalOfLengths += shipLength(s);
-        if (shipSymbol(s) == symbol)
-        {
-            cout << "Ship symbol " << symbol
-                 << " must not be used for more than one ship" << endl;
-            return false;
-        }
+        cout << "Ship symbol " << symbol
+             << " must not be used for more than one ship" << endl;
+        return false;
     }
-    if (totalOfLengths + length > rows() * cols())
+    if (fleet().totalCells + length > rows() * cols())
     {
         cout << "Board is too small to fit all ships" << endl;
         return false;
@@ -321,12 +923,98 @@ string Game::shipName(int shipId) const
     return m_impl->shipName(shipId);
 }
 
+const Fleet& Game::fleet() const
+{
+    return m_impl->fleet();
+}
+
+void Game::setSalvo(int shotsPerTurn, bool oneShotPerShip)
+{
+    if (shotsPerTurn < 1)
+    {
+        cout << "Bad salvo size " << shotsPerTurn << "; it must be >= 1" << endl;
+        return;
+    }
+    m_impl->setSalvo(shotsPerTurn, oneShotPerShip);
+}
+
+void Game::setTimeControl(double moveLimitMs, double gameLimitMs, TimeoutPolicy policy)
+{
+    if (moveLimitMs < 0  ||  gameLimitMs < 0)
+    {
+        cout << "Time limits must be >= 0 (0 means unlimited)" << endl;
+        return;
+    }
+    m_impl->setTimeControl(moveLimitMs, gameLimitMs, policy);
+}
+
+void Game::setVerbose(bool verbose)
+{
+    m_impl->setVerbose(verbose);
+}
+
+bool Game::outOfTime() const
+{
+    return m_impl->outOfTime();
+}
+
+PlayerClock Game::playerClock(const Player* p) const
+{
+    return m_impl->playerClock(p);
+}
+
+void Game::setLatencyTable(const Player* p, LatencyTable* table)
+{
+    m_impl->setLatencyTable(p, table);
+}
+
+void Game::setCalibrationTable(const Player* p, CalibrationTable* table)
+{
+    m_impl->setCalibrationTable(p, table);
+}
+
+void Game::setSeed(unsigned seed)
+{
+    m_impl->setSeed(seed);
+}
+
+void Game::setRecordWriter(RecordWriter* writer)
+{
+    m_impl->setRecordWriter(writer);
+}
+
+const GameRecord& Game::lastRecord() const
+{
+    return m_impl->lastRecord();
+}
+
 Player* Game::play(Player* p1, Player* p2, bool shouldPause)
 {
     if (p1 == nullptr  ||  p2 == nullptr  ||  nShips() == 0)
         return nullptr;
     Board b1(*this);
     Board b2(*this);
-    return m_impl->play(p1, p2, b1, b2, shouldPause);
+    bool loaded;
+    return m_impl->play(p1, p2, b1, b2, shouldPause, nullptr, loaded);
+}
+
+void Game::setCheckpoint(double everyMs, function<void()> save)
+{
+    m_impl->setCheckpoint(everyMs, save);
+}
+
+bool Game::saveState(ostream& out) const
+{
+    return m_impl->saveState(out);
+}
+
+Player* Game::resume(Player* p1, Player* p2, istream& state, bool& loaded, bool shouldPause)
+{
+    loaded = false;
+    if (p1 == nullptr  ||  p2 == nullptr  ||  nShips() == 0)
+        return nullptr;
+    Board b1(*this);
+    Board b2(*this);
+    return m_impl->play(p1, p2, b1, b2, shouldPause, &state, loaded);
 }
 
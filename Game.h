@@ -1,12 +1,36 @@
 #ifndef GAME_INCLUDED
 #define GAME_INCLUDED
 
+#include "Accounting.h"
 #include <string>
+#include <iosfwd>
+#include <functional>
 #include <cassert>
 
 class Point;
 class Player;
 class GameImpl;
+struct Fleet;
+struct LatencyTable;
+struct CalibrationTable;
+class RecordWriter;
+struct GameRecord;
+
+  // What happens to a player who overruns a time limit
+enum TimeoutPolicy {
+    FORFEIT, RANDOM_MOVE
+};
+
+  // Time and memory a player has spent in its calls during one game
+struct PlayerClock
+{
+    double usedMs;
+    double maxCallMs; // its slowest call
+    int calls;
+    int timeouts;
+    double cpuMs;     // estimated thread CPU time
+    HeapUsage heap;   // allocations made inside its calls
+};
 
 class Game
 {
@@ -22,7 +46,27 @@ class Game
     int shipLength(int shipId) const;
     char shipSymbol(int shipId) const;
     std::string shipName(int shipId) const;
+    const Fleet& fleet() const;
+    void setSalvo(int shotsPerTurn, bool oneShotPerShip = false);
+    void setTimeControl(double moveLimitMs, double gameLimitMs, TimeoutPolicy policy = FORFEIT);
+    void setVerbose(bool verbose);
+    bool outOfTime() const;
+    PlayerClock playerClock(const Player* p) const;
+    void setLatencyTable(const Player* p, LatencyTable* table);
+    void setCalibrationTable(const Player* p, CalibrationTable* table);
+    void setSeed(unsigned seed);
+    void setRecordWriter(RecordWriter* writer);
+    const GameRecord& lastRecord() const;
     Player* play(Player* p1, Player* p2, bool shouldPause = true);
+      // Checkpointing: during play, save is called between turns at
+      // most every everyMs, and from inside it saveState writes the
+      // game so far (boards, players, random numbers) on one line.
+      // resume plays out a saved game with newly created players of the
+      // same types, passed in the same order as to play; loaded is false,
+      // and nothing is played, if the state doesn't fit them.
+    void setCheckpoint(double everyMs, std::function<void()> save);
+    bool saveState(std::ostream& out) const;
+    Player* resume(Player* p1, Player* p2, std::istream& state, bool& loaded, bool shouldPause = true);
       // We prevent a Game object from being copied or assigned
     Game(const Game&) = delete;
     Game& operator=(const Game&) = delete;
@@ -0,0 +1,410 @@
+#include "GameRecord.h"
+#include <cstring>
+
+using namespace std;
+
+namespace
+{
+    const char MAGIC[4] = { 'B', 'S', 'G', 'R' };
+    const int FILE_HEADER = 8;
+    const unsigned char OFF_BOARD = 0x7F;
+
+    // Bounds-checked cursor over one record
+    struct Cursor
+    {
+        const unsigned char* p;
+        const unsigned char* end;
+        bool ok;
+        bool more() const { return p < end; }
+        int u8()
+        {
+            if (p >= end)
+            {
+                ok = false;
+                return 0;
+            }
+            return *p++;
+        }
+        string name()
+        {
+            int len = u8();
+            if (end - p < len)
+            {
+                ok = false;
+                return "";
+            }
+            string s(reinterpret_cast<const char*>(p), len);
+            p += len;
+            return s;
+        }
+    };
+
+    void encodeShot(const GameRecord& record, const GameRecord::Shot& shot, string& out)
+    {
+        bool onBoard = shot.p.r >= 0 && shot.p.r < record.rows && shot.p.c >= 0 && shot.p.c < record.cols;
+        int cell = onBoard ? shot.p.r * record.cols + shot.p.c : OFF_BOARD;
+        bool repeat = onBoard && !shot.valid;
+        if (!shot.shotHit && !repeat)
+        {
+            putU8(out, cell);
+            return;
+        }
+        putU8(out, cell | 0x80);
+        putU8(out, (shot.shotHit ? shot.shipId & 0x3F : 0) | (shot.shipDestroyed ? 0x40 : 0) | (repeat ? 0x80 : 0));
+    }
+
+    void decodeShot(const GameRecord& record, int who, Cursor& in, GameRecord::Shot& shot)
+    {
+        int b = in.u8();
+        int cell = b & 0x7F;
+        shot.who = who;
+        shot.p = cell == OFF_BOARD ? Point(-1, -1) : Point(cell / record.cols, cell % record.cols);
+        shot.valid = cell != OFF_BOARD;
+        shot.shotHit = false;
+        shot.shipDestroyed = false;
+        shot.shipId = -1;
+        if (b & 0x80)
+        {
+            int extra = in.u8();
+            if (extra & 0x80)
+                shot.valid = false;
+            else
+            {
+                shot.shotHit = true;
+                shot.shipId = extra & 0x3F;
+                shot.shipDestroyed = (extra & 0x40) != 0;
+            }
+        }
+    }
+}
+
+GameRecord::GameRecord()
+{
+    clear();
+}
+
+void GameRecord::clear()
+{
+    rows = cols = 0;
+    seeded = false;
+    seed = 0;
+    shotsPerTurn = 1;
+    winner = -1;
+    ships.clear();
+    for (int who = 0; who < 2; who++)
+    {
+        names[who].clear();
+        placements[who].clear();
+    }
+    shots.clear();
+}
+
+//####################
+// Appends a record, with its length prefix, to out
+//####################
+void encodeRecord(const GameRecord& record, string& out)
+{
+    size_t start = out.size();
+    putU32(out, 0);
+
+    bool salvo = record.shotsPerTurn != 1;
+    int winner = record.winner < 0 ? 2 : record.winner;
+    putU8(out, record.rows);
+    putU8(out, record.cols);
+    putU8(out, (salvo ? 1 : 0) | (record.seeded ? 2 : 0) | (winner << 2));
+    putU8(out, record.shotsPerTurn);
+    putU32(out, record.seed);
+
+    putU8(out, static_cast<int>(record.ships.size()));
+    for (const ShipType& st : record.ships)
+    {
+        putU8(out, st.length);
+        putU8(out, st.symbol);
+        putName(out, st.name);
+    }
+    for (int who = 0; who < 2; who++)
+        putName(out, record.names[who]);
+    for (int who = 0; who < 2; who++)
+        for (size_t shipId = 0; shipId < record.ships.size(); shipId++)
+        {
+            // Missing placements (game ended before placing) are written as cell 0
+            const GameRecord::Placement* pl = shipId < record.placements[who].size() ? &record.placements[who][shipId] : nullptr;
+            int cell = pl != nullptr ? pl->topOrLeft.r * record.cols + pl->topOrLeft.c : 0;
+            putU8(out, cell | (pl != nullptr && pl->dir == VERTICAL ? 0x80 : 0));
+        }
+
+    for (size_t n = 0; n < record.shots.size(); )
+    {
+        if (!salvo)
+        {
+            encodeShot(record, record.shots[n++], out);
+            continue;
+        }
+
+        // Consecutive shots by one player form a turn
+        int who = record.shots[n].who;
+        size_t end = n;
+        while (end < record.shots.size() && end - n < 0x7F && record.shots[end].who == who)
+            end++;
+        putU8(out, static_cast<int>(end - n) | (who << 7));
+        for (; n < end; n++)
+            encodeShot(record, record.shots[n], out);
+    }
+
+    uint32_t length = static_cast<uint32_t>(out.size() - start - 4);
+    for (int i = 0; i < 4; i++)
+        out[start + i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+}
+
+//####################
+// Parses one record body (without its length prefix)
+// Returns false if it is malformed
+//####################
+bool decodeRecord(const char* data, size_t size, GameRecord& record)
+{
+    record.clear();
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    Cursor in = { p, p + size, true };
+
+    record.rows = in.u8();
+    record.cols = in.u8();
+    int flags = in.u8();
+    record.shotsPerTurn = in.u8();
+    if (!in.ok || in.end - in.p < 4)
+        return false;
+    record.seed = getU32(in.p);
+    in.p += 4;
+    bool salvo = (flags & 1) != 0;
+    record.seeded = (flags & 2) != 0;
+    int winner = (flags >> 2) & 3;
+    record.winner = winner == 2 ? -1 : winner;
+    if (record.rows < 1 || record.rows > MAXROWS || record.cols < 1 || record.cols > MAXCOLS)
+        return false;
+
+    int nShips = in.u8();
+    for (int shipId = 0; shipId < nShips && in.ok; shipId++)
+    {
+        int length = in.u8();
+        char symbol = static_cast<char>(in.u8());
+        record.ships.push_back(ShipType(length, symbol, in.name()));
+    }
+    for (int who = 0; who < 2; who++)
+        record.names[who] = in.name();
+    for (int who = 0; who < 2; who++)
+        for (int shipId = 0; shipId < nShips; shipId++)
+        {
+            int b = in.u8();
+            int cell = b & 0x7F;
+            record.placements[who].push_back(GameRecord::Placement{
+                Point(cell / record.cols, cell % record.cols), (b & 0x80) ? VERTICAL : HORIZONTAL });
+        }
+
+    int who = 0;
+    while (in.ok && in.more())
+    {
+        int count = 1;
+        if (salvo)
+        {
+            int b = in.u8();
+            count = b & 0x7F;
+            who = b >> 7;
+        }
+        for (int n = 0; n < count && in.ok; n++)
+        {
+            GameRecord::Shot shot;
+            decodeShot(record, who, in, shot);
+            record.shots.push_back(shot);
+        }
+        if (!salvo)
+            who = 1 - who;
+    }
+    return in.ok;
+}
+
+//******************** RecordWriter functions *************************
+
+RecordWriter::RecordWriter() : m_open(false), m_closing(false), m_nRecords(0) {}
+
+RecordWriter::~RecordWriter()
+{
+    close();
+}
+
+//####################
+// Opens a record file for appending, writing the
+// file header if it is new
+// Returns false if it can't be written or is not a
+// record file of this version
+//####################
+bool RecordWriter::open(const string& path)
+{
+    if (m_open)
+        return false;
+
+    // A new or empty file gets a header; anything else must have ours
+    char header[FILE_HEADER] = {};
+    ifstream existing(path, ios::binary);
+    existing.read(header, FILE_HEADER);
+    bool isNew = existing.gcount() == 0;
+    if (!isNew && (existing.gcount() < FILE_HEADER || memcmp(header, MAGIC, 4) != 0 || header[4] != RECORD_VERSION))
+        return false;
+    existing.close();
+
+    m_file.open(path, ios::binary | ios::app);
+    if (!m_file)
+        return false;
+    if (isNew)
+    {
+        memcpy(header, MAGIC, 4);
+        header[4] = RECORD_VERSION;
+        m_file.write(header, FILE_HEADER);
+    }
+
+    m_open = true;
+    m_closing = false;
+    m_nRecords = 0;
+    m_thread = thread(&RecordWriter::writerLoop, this);
+    return true;
+}
+
+//####################
+// Queues a record; only copies bytes under the lock
+//####################
+void RecordWriter::write(const GameRecord& record)
+{
+    static thread_local string encoded;
+    encoded.clear();
+    encodeRecord(record, encoded);
+
+    lock_guard<mutex> lock(m_lock);
+    if (!m_open)
+        return;
+    m_front += encoded;
+    m_nRecords++;
+    if (m_front.size() >= FLUSH_BYTES && m_back.empty())
+    {
+        m_front.swap(m_back);
+        m_wake.notify_one();
+    }
+}
+
+void RecordWriter::writerLoop()
+{
+    unique_lock<mutex> lock(m_lock);
+    while (true)
+    {
+        m_wake.wait(lock, [this] { return !m_back.empty() || m_closing; });
+        if (m_back.empty())
+            return;
+
+        // Producers leave m_back alone while it is not empty
+        lock.unlock();
+        m_file.write(m_back.data(), m_back.size());
+        lock.lock();
+        m_back.clear();
+
+        // Writes that filled the front while we were busy
+        if (m_front.size() >= FLUSH_BYTES)
+            m_front.swap(m_back);
+    }
+}
+
+//####################
+// Writes everything queued and closes the file
+//####################
+void RecordWriter::close()
+{
+    {
+        lock_guard<mutex> lock(m_lock);
+        if (!m_open)
+            return;
+        m_closing = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+
+    lock_guard<mutex> lock(m_lock);
+    m_file.write(m_back.data(), m_back.size());
+    m_file.write(m_front.data(), m_front.size());
+    m_back.clear();
+    m_front.clear();
+    m_file.close();
+    m_open = false;
+}
+
+long long RecordWriter::nRecords() const
+{
+    lock_guard<mutex> lock(m_lock);
+    return m_nRecords;
+}
+
+//******************** RecordReader functions *************************
+
+bool RecordReader::open(const string& path)
+{
+    m_file.open(path, ios::binary);
+    char header[FILE_HEADER];
+    if (!m_file || !m_file.read(header, FILE_HEADER) || memcmp(header, MAGIC, 4) != 0)
+        return false;
+    m_version = header[4];
+    return m_version == RECORD_VERSION;
+}
+
+//####################
+// Reads the next record
+// Returns false at the end of the file or on a bad record
+//####################
+bool RecordReader::next(GameRecord& record)
+{
+    unsigned char prefix[4];
+    if (!m_file.read(reinterpret_cast<char*>(prefix), 4))
+        return false;
+    uint32_t length = getU32(prefix);
+    m_buffer.resize(length);
+    if (!m_file.read(&m_buffer[0], length))
+        return false;
+    return decodeRecord(m_buffer.data(), length, record);
+}
+
+//******************** MappedRecords functions ************************
+
+//####################
+// Maps a record file and indexes its records
+// A truncated last record is ignored
+//####################
+bool MappedRecords::open(const string& path)
+{
+    m_offsets.clear();
+    if (!m_file.open(path))
+        return false;
+
+    const char* data = m_file.data();
+    size_t size = m_file.size();
+    if (size < FILE_HEADER || memcmp(data, MAGIC, 4) != 0 || data[4] != RECORD_VERSION)
+    {
+        m_file.close();
+        return false;
+    }
+    const unsigned char* base = reinterpret_cast<const unsigned char*>(data);
+    for (size_t pos = FILE_HEADER; pos + 4 <= size; )
+    {
+        size_t length = getU32(base + pos);
+        if (pos + 4 + length > size)
+            break;
+        m_offsets.push_back(pos + 4);
+        pos += 4 + length;
+    }
+    return true;
+}
+
+//####################
+// Decodes record n (0-based)
+//####################
+bool MappedRecords::get(size_t n, GameRecord& record) const
+{
+    if (n >= m_offsets.size())
+        return false;
+    size_t start = m_offsets[n];
+    size_t length = getU32(reinterpret_cast<const unsigned char*>(m_file.data()) + start - 4);
+    return decodeRecord(m_file.data() + start, length, record);
+}
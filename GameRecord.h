@@ -0,0 +1,128 @@
+#ifndef GAMERECORD_INCLUDED
+#define GAMERECORD_INCLUDED
+
+#include "globals.h"
+#include "utility.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+  // Everything needed to replay one game
+struct GameRecord
+{
+    struct Placement
+    {
+        Point topOrLeft;
+        Direction dir;
+    };
+    struct Shot
+    {
+        int who;         // 0 for the player who moved first
+        Point p;         // (-1,-1) for a shot off the board
+        bool valid;
+        bool shotHit;
+        bool shipDestroyed;
+        int shipId;
+    };
+
+    GameRecord();
+    void clear();
+
+    int rows;
+    int cols;
+    bool seeded;
+    unsigned seed;       // seedRandom value the game was played with
+    int shotsPerTurn;    // 1 for the classic game, 0 for one per ship afloat
+    int winner;          // 0, 1, or -1 if undecided
+    std::vector<ShipType> ships;
+    std::string names[2];
+    std::vector<Placement> placements[2];
+    std::vector<Shot> shots;
+};
+
+  // Binary game-record files
+  //
+  // A file is an 8-byte header ("BSGR", version, 3 reserved bytes)
+  // followed by any number of records, each a little-endian u32 byte
+  // count and then:
+  //   u8 rows, u8 cols, u8 flags, u8 shotsPerTurn, u32 seed, u8 nShips
+  //   per ship: u8 length, u8 symbol, u8 name length, name
+  //   per player: u8 name length, name
+  //   per player, per ship: u8 cell (r*cols + c), bit 7 set if vertical
+  //   shots until the end of the record
+  // flags: bit 0 salvo, bit 1 seeded, bits 2-3 winner (2 = none)
+  //
+  // A shot is one byte: the cell, with 0x7F for off the board; bit 7
+  // means a second byte follows with the ship id in bits 0-5, bit 6 set
+  // if it sank, bit 7 set if the cell had already been shot. Classic
+  // games alternate shooters; salvo games group each turn's shots behind
+  // a byte holding the count, bit 7 set for the second player.
+const int RECORD_VERSION = 1;
+
+void encodeRecord(const GameRecord& record, std::string& out);
+bool decodeRecord(const char* data, std::size_t size, GameRecord& record);
+
+  // Appends records to a file from any number of threads
+  //
+  // Encoded records collect in a front buffer; a background
+  // thread writes the back buffer, so callers never wait on disk
+class RecordWriter
+{
+  public:
+    RecordWriter();
+    ~RecordWriter();
+    bool open(const std::string& path);
+    void write(const GameRecord& record);
+    void close();
+    long long nRecords() const;
+    RecordWriter(const RecordWriter&) = delete;
+    RecordWriter& operator=(const RecordWriter&) = delete;
+
+  private:
+    static const std::size_t FLUSH_BYTES = 1 << 20;
+    void writerLoop();
+
+    std::ofstream m_file;
+    std::thread m_thread;
+    mutable std::mutex m_lock;
+    std::condition_variable m_wake;
+    std::string m_front;    // filled by write
+    std::string m_back;     // owned by the writer thread while not empty
+    bool m_open;
+    bool m_closing;
+    long long m_nRecords;
+};
+
+  // Reads records back in file order
+class RecordReader
+{
+  public:
+    bool open(const std::string& path);
+    bool next(GameRecord& record);
+    int version() const { return m_version; }
+
+  private:
+    std::ifstream m_file;
+    std::string m_buffer;
+    int m_version = 0;
+};
+
+  // Random access to every record of a file, mapped into memory
+  //
+  // Safe to read from many threads at once
+class MappedRecords
+{
+  public:
+    bool open(const std::string& path);
+    std::size_t size() const { return m_offsets.size(); }
+    bool get(std::size_t n, GameRecord& record) const;
+
+  private:
+    MappedFile m_file;
+    std::vector<std::size_t> m_offsets;  // start of each record body
+};
+
+#endif // GAMERECORD_INCLUDED
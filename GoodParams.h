@@ -0,0 +1,19 @@
+#ifndef GOODPARAMS_INCLUDED
+#define GOODPARAMS_INCLUDED
+
+  // The constants GoodPlayer's density maps are built with
+  //
+  // One byte each, so every GoodPlayer carries its own without leaving
+  // its two cache lines. The production values are TUNED_GOOD_PARAMS in
+  // GoodTuned.h, which Tune/tune.cpp writes.
+struct GoodParams
+{
+    unsigned char lineWeight;    // targeting: multiplies cells in line with two hits
+    unsigned char proximity;     // targeting: such a cell d away from the first hit is
+                                 // also multiplied by proximity / d, rounded down
+    unsigned char parityStride;  // hunting: only cells with r and c equal modulo this
+                                 // are fired at; 0 uses the smallest ship afloat,
+                                 // 1 fires anywhere
+};
+
+#endif // GOODPARAMS_INCLUDED
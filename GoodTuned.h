@@ -0,0 +1,11 @@
+// Written by Tune/tune.cpp; rerun it rather than editing by hand
+// Seed 1, 63 candidates, boards placed by good: { 5, 24, 1 } took -1.04 +/- 0.17 shots per board against { 2, 10, 0 }
+
+#ifndef GOODTUNED_INCLUDED
+#define GOODTUNED_INCLUDED
+
+#include "GoodParams.h"
+
+constexpr GoodParams TUNED_GOOD_PARAMS = { 5, 24, 1 };
+
+#endif // GOODTUNED_INCLUDED
@@ -0,0 +1,262 @@
+#include "Histogram.h"
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+
+using namespace std;
+
+const char* const CALL_NAMES[NCALLKINDS] = {
+    "placeShips", "recommendAttack", "recordAttackResult", "recordAttackByOpponent"
+};
+
+static const char* const PHASE_NAMES[NPHASES] = { "early", "mid", "target" };
+
+LatencyHistogram::LatencyHistogram() : m_counts{}, m_count(0), m_max(0) {}
+
+//####################
+// Index of the bucket holding a value
+//####################
+int LatencyHistogram::bucketOf(uint64_t ns)
+{
+    if (ns < 32)
+        return static_cast<int>(ns);
+
+    // Position of the highest set bit, by binary search
+    int e = 0;
+    for (int step = 32; step > 0; step /= 2)
+        if (ns >> (e + step))
+            e += step;
+
+    // 16 sub-buckets from the 4 bits below the highest
+    int sub = static_cast<int>((ns >> (e - 4)) & 15);
+    return 32 + (e - 5) * 16 + sub;
+}
+
+//####################
+// Middle of the value range a bucket covers
+//####################
+double LatencyHistogram::bucketMidpoint(int bucket)
+{
+    if (bucket < 32)
+        return bucket;
+    int e = (bucket - 32) / 16 + 5;
+    int sub = (bucket - 32) % 16;
+    double width = static_cast<double>(uint64_t(1) << (e - 4));
+    return (16 + sub) * width + width / 2;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    for (int b = 0; b < NBUCKETS; b++)
+        m_counts[b] += other.m_counts[b];
+    m_count += other.m_count;
+    if (other.m_max > m_max)
+        m_max = other.m_max;
+}
+
+void LatencyHistogram::save(ostream& out) const
+{
+    int nUsed = 0;
+    for (int b = 0; b < NBUCKETS; b++)
+        if (m_counts[b] != 0)
+            nUsed++;
+    out << m_count << ' ' << m_max << ' ' << nUsed;
+    for (int b = 0; b < NBUCKETS; b++)
+        if (m_counts[b] != 0)
+            out << ' ' << b << ' ' << m_counts[b];
+}
+
+//####################
+// Reads what save wrote, replacing the contents
+// Returns false if it is malformed
+//####################
+bool LatencyHistogram::load(istream& in)
+{
+    *this = LatencyHistogram();
+    int nUsed;
+    if (!(in >> m_count >> m_max >> nUsed) || nUsed < 0 || nUsed > NBUCKETS)
+        return false;
+    uint64_t total = 0;
+    for (int n = 0; n < nUsed; n++)
+    {
+        int b;
+        uint64_t count;
+        if (!(in >> b >> count) || b < 0 || b >= NBUCKETS)
+            return false;
+        m_counts[b] = count;
+        total += count;
+    }
+    return total == m_count;
+}
+
+//####################
+// Value below which a fraction q of samples fall
+//####################
+double LatencyHistogram::percentile(double q) const
+{
+    if (m_count == 0)
+        return 0;
+    double rank = q * m_count;
+    uint64_t seen = 0;
+    for (int b = 0; b < NBUCKETS; b++)
+    {
+        seen += m_counts[b];
+        if (seen >= rank && seen > 0)
+        {
+            double mid = bucketMidpoint(b);
+            return mid < m_max ? mid : m_max;
+        }
+    }
+    return m_max;
+}
+
+void LatencyTable::merge(const LatencyTable& other)
+{
+    for (int k = 0; k < NCALLKINDS; k++)
+        for (int p = 0; p < NPHASES; p++)
+            histograms[k][p].merge(other.histograms[k][p]);
+}
+
+//####################
+// One line per call and phase with samples, in microseconds
+//####################
+void LatencyTable::print(const string& label, ostream& out) const
+{
+
+    for (int k = 0; k < NCALLKINDS; k++)
+        for (int p = 0; p < NPHASES; p++)
+        {
+            const LatencyHistogram& h = histograms[k][p];
+            if (h.count() == 0)
+                continue;
+            out << "  " << label << " " << CALL_NAMES[k] << " " << PHASE_NAMES[p]
+                << fixed << setprecision(2)
+                << ": n=" << h.count()
+                << " p50=" << h.percentile(0.5) / 1000
+                << " p99=" << h.percentile(0.99) / 1000
+                << " p99.9=" << h.percentile(0.999) / 1000
+                << " max=" << h.max() / 1000.0 << " us" << endl;
+        }
+}
+
+//******************** CalibrationHistogram functions *****************
+
+CalibrationHistogram::CalibrationHistogram() : m_bins{}, m_count(0), m_brierSum(0), m_logLossSum(0) {}
+
+void CalibrationHistogram::record(double predicted, bool hit)
+{
+    if (predicted < 0)
+        predicted = 0;
+    if (predicted > 1)
+        predicted = 1;
+    int b = static_cast<int>(predicted * NBINS);
+    if (b == NBINS)
+        b--;
+    m_bins[b].count++;
+    m_bins[b].predictedSum += predicted;
+    m_bins[b].hits += hit;
+
+    double outcome = hit ? 1 : 0;
+    double clamped = predicted < EPSILON ? EPSILON : predicted > 1 - EPSILON ? 1 - EPSILON : predicted;
+    m_count++;
+    m_brierSum += (predicted - outcome) * (predicted - outcome);
+    m_logLossSum -= log(hit ? clamped : 1 - clamped);
+}
+
+void CalibrationHistogram::merge(const CalibrationHistogram& other)
+{
+    for (int b = 0; b < NBINS; b++)
+    {
+        m_bins[b].count += other.m_bins[b].count;
+        m_bins[b].predictedSum += other.m_bins[b].predictedSum;
+        m_bins[b].hits += other.m_bins[b].hits;
+    }
+    m_count += other.m_count;
+    m_brierSum += other.m_brierSum;
+    m_logLossSum += other.m_logLossSum;
+}
+
+double CalibrationHistogram::hitRate() const
+{
+    uint64_t hits = 0;
+    for (int b = 0; b < NBINS; b++)
+        hits += m_bins[b].hits;
+    return m_count > 0 ? double(hits) / m_count : 0;
+}
+
+double CalibrationHistogram::meanPredicted() const
+{
+    double sum = 0;
+    for (int b = 0; b < NBINS; b++)
+        sum += m_bins[b].predictedSum;
+    return m_count > 0 ? sum / m_count : 0;
+}
+
+void CalibrationHistogram::save(ostream& out) const
+{
+    int nUsed = 0;
+    for (int b = 0; b < NBINS; b++)
+        if (m_bins[b].count != 0)
+            nUsed++;
+    streamsize precision = out.precision(17);
+    out << m_count << ' ' << m_brierSum << ' ' << m_logLossSum << ' ' << nUsed;
+    for (int b = 0; b < NBINS; b++)
+        if (m_bins[b].count != 0)
+            out << ' ' << b << ' ' << m_bins[b].count << ' ' << m_bins[b].predictedSum << ' ' << m_bins[b].hits;
+    out.precision(precision);
+}
+
+//####################
+// Reads what save wrote, replacing the contents
+// Returns false if it is malformed
+//####################
+bool CalibrationHistogram::load(istream& in)
+{
+    *this = CalibrationHistogram();
+    int nUsed;
+    if (!(in >> m_count >> m_brierSum >> m_logLossSum >> nUsed) || nUsed < 0 || nUsed > NBINS)
+        return false;
+    uint64_t total = 0;
+    for (int n = 0; n < nUsed; n++)
+    {
+        int b;
+        Bin bin;
+        if (!(in >> b >> bin.count >> bin.predictedSum >> bin.hits) || b < 0 || b >= NBINS || bin.hits > bin.count)
+            return false;
+        m_bins[b] = bin;
+        total += bin.count;
+    }
+    return total == m_count;
+}
+
+void CalibrationTable::merge(const CalibrationTable& other)
+{
+    for (int p = 0; p < NPHASES; p++)
+        phases[p].merge(other.phases[p]);
+}
+
+//####################
+// Two lines per phase with shots: the scores, then
+// the reliability curve as predicted:observed (shots)
+// for every nonempty bin
+//####################
+void CalibrationTable::print(const string& label, ostream& out) const
+{
+    for (int p = 0; p < NPHASES; p++)
+    {
+        const CalibrationHistogram& h = phases[p];
+        if (h.count() == 0)
+            continue;
+        out << "  " << label << " " << PHASE_NAMES[p] << fixed << setprecision(4)
+            << ": n=" << h.count()
+            << " predicted=" << h.meanPredicted()
+            << " hit=" << h.hitRate()
+            << " brier=" << h.brier()
+            << " logloss=" << h.logLoss() << endl
+            << "   " << setprecision(2);
+        for (int b = 0; b < CalibrationHistogram::NBINS; b++)
+            if (h.binCount(b) > 0)
+                out << ' ' << h.binPredicted(b) << ':' << h.binHitRate(b) << " (" << h.binCount(b) << ")";
+        out << endl;
+    }
+}
@@ -0,0 +1,122 @@
+#ifndef HISTOGRAM_INCLUDED
+#define HISTOGRAM_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <iosfwd>
+
+  // Build with -DNO_LATENCY_HISTOGRAMS to compile recording out
+#ifdef NO_LATENCY_HISTOGRAMS
+const bool LATENCY_HISTOGRAMS = false;
+#else
+const bool LATENCY_HISTOGRAMS = true;
+#endif
+
+  // Log-bucketed histogram of nanosecond latencies
+  // 
+  // Values below 32 ns get exact buckets; above that each power of
+  // two is split into 16 linear buckets, so any reported value is
+  // within about 6% of the true one
+class LatencyHistogram
+{
+  public:
+    static const int NBUCKETS = 32 + 59 * 16;
+
+    LatencyHistogram();
+    void record(std::uint64_t ns)
+    {
+        m_counts[bucketOf(ns)]++;
+        m_count++;
+        if (ns > m_max)
+            m_max = ns;
+    }
+    void merge(const LatencyHistogram& other);
+    std::uint64_t count() const { return m_count; }
+    std::uint64_t max() const { return m_max; }
+    double percentile(double q) const;
+      // Text form: count, max, then bucket/count pairs for nonempty buckets
+    void save(std::ostream& out) const;
+    bool load(std::istream& in);
+
+  private:
+    static int bucketOf(std::uint64_t ns);
+    static double bucketMidpoint(int bucket);
+
+    std::uint64_t m_counts[NBUCKETS];
+    std::uint64_t m_count;
+    std::uint64_t m_max;
+};
+
+  // Player calls that Game times
+enum CallKind {
+    PLACE_SHIPS, RECOMMEND_ATTACK, RECORD_RESULT, RECORD_OPPONENT, NCALLKINDS
+};
+
+extern const char* const CALL_NAMES[NCALLKINDS];
+
+  // Stage of the game from the attacker's side:
+  // hunting before or after its first 20 shots, or
+  // targeting while a ship it hit is still afloat
+enum GamePhase {
+    EARLY_HUNT, MID_GAME, TARGET_MODE, NPHASES
+};
+
+  // One strategy's latencies by call and phase
+struct LatencyTable
+{
+    LatencyHistogram histograms[NCALLKINDS][NPHASES];
+    void merge(const LatencyTable& other);
+    void print(const std::string& label, std::ostream& out) const;
+};
+
+  // Reliability histogram of a strategy's predicted hit probabilities
+  //
+  // Each shot falls in one of NBINS equal-width bins by its prediction;
+  // a bin keeps the mean prediction and the share that hit, the points
+  // of a reliability curve. The Brier score and log-loss are kept over
+  // all shots, with predictions clamped to [EPSILON, 1 - EPSILON] for
+  // the log-loss.
+class CalibrationHistogram
+{
+  public:
+    static const int NBINS = 10;
+    static constexpr double EPSILON = 1e-4;
+
+    CalibrationHistogram();
+    void record(double predicted, bool hit);
+    void merge(const CalibrationHistogram& other);
+    std::uint64_t count() const { return m_count; }
+    double brier() const { return m_count > 0 ? m_brierSum / m_count : 0; }
+    double logLoss() const { return m_count > 0 ? m_logLossSum / m_count : 0; }
+    double hitRate() const;
+    double meanPredicted() const;
+      // Text form: count, sums, then bin/count/sum/hits for nonempty bins
+    void save(std::ostream& out) const;
+    bool load(std::istream& in);
+
+    std::uint64_t binCount(int b) const { return m_bins[b].count; }
+    double binPredicted(int b) const { return m_bins[b].count > 0 ? m_bins[b].predictedSum / m_bins[b].count : 0; }
+    double binHitRate(int b) const { return m_bins[b].count > 0 ? double(m_bins[b].hits) / m_bins[b].count : 0; }
+
+  private:
+    struct Bin
+    {
+        std::uint64_t count;
+        double predictedSum;
+        std::uint64_t hits;
+    };
+    Bin m_bins[NBINS];
+    std::uint64_t m_count;
+    double m_brierSum;
+    double m_logLossSum;
+};
+
+  // One strategy's calibration by phase
+struct CalibrationTable
+{
+    CalibrationHistogram phases[NPHASES];
+    void merge(const CalibrationTable& other);
+    void print(const std::string& label, std::ostream& out) const;
+};
+
+#endif // HISTOGRAM_INCLUDED
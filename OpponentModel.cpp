@@ -0,0 +1,204 @@
+#include "OpponentModel.h"
+#include "Game.h"
+#include <atomic>
+#include <cstring>
+
+using namespace std;
+
+static_assert(sizeof(atomic<uint32_t>) == sizeof(uint32_t) && atomic<uint32_t>::is_always_lock_free,
+              "model counts are updated in place as atomics");
+
+namespace
+{
+    const char MAGIC[4] = { 'B', 'S', 'O', 'M' };
+    const int VERSION = 1;
+    const int HEADER = 8;  // magic, version, rows, cols, ships
+    const uint32_t MAX_WEIGHT = 64 * PRIOR_ONE;
+
+    // Header and ship lengths, rounded up to keep the counts aligned
+    size_t countsOffset(int nShips)
+    {
+        return (HEADER + nShips + 3) / 4 * 4 + sizeof(uint32_t);
+    }
+
+    // Smoothed observed count per game over the uniform one
+    int weight(double observed, double uniform, double nGames)
+    {
+        double p = (observed + OpponentModel::PRIOR_GAMES * uniform) / (nGames + OpponentModel::PRIOR_GAMES);
+        double w = PRIOR_ONE * p / uniform + 0.5;
+        return w < 1 ? 1 : w > MAX_WEIGHT ? MAX_WEIGHT : static_cast<int>(w);
+    }
+
+    atomic<uint32_t>& shared(uint32_t* p)
+    {
+        return *reinterpret_cast<atomic<uint32_t>*>(p);
+    }
+
+    // Cells a ship covers from its top or left end, or 0 if it runs off
+    int shipCells(Point start, int length, Direction dir, int rows, int cols, int* cells)
+    {
+        int dr = dir == VERTICAL ? 1 : 0;
+        int dc = dir == VERTICAL ? 0 : 1;
+        if (start.r < 0 || start.c < 0 || start.r + dr * (length - 1) >= rows ||
+            start.c + dc * (length - 1) >= cols)
+            return 0;
+        for (int i = 0; i < length; i++)
+            cells[i] = cellIndex(Point(start.r + dr * i, start.c + dc * i));
+        return length;
+    }
+}
+
+OpponentModel::OpponentModel() : m_rows(0), m_cols(0), m_games(nullptr), m_counts(nullptr), m_shots(nullptr) {}
+
+//####################
+// Maps a model file, writing a header for g's board
+// and fleet if the file is new
+//####################
+bool OpponentModel::open(const string& path, const Game& g)
+{
+    close();
+    int nShips = g.nShips();
+    if (nShips < 1 || nShips > 255)
+        return false;
+    size_t offset = countsOffset(nShips);
+    size_t size = offset + sizeof(uint32_t) * (nShips * 2 + 1) * MAXCELLS;
+    if (!m_file.openShared(path, size))
+        return false;
+
+    unsigned char* base = reinterpret_cast<unsigned char*>(m_file.writableData());
+    unsigned char header[HEADER + 255];
+    memcpy(header, MAGIC, 4);
+    header[4] = VERSION;
+    header[5] = static_cast<unsigned char>(g.rows());
+    header[6] = static_cast<unsigned char>(g.cols());
+    header[7] = static_cast<unsigned char>(nShips);
+    for (int shipId = 0; shipId < nShips; shipId++)
+        header[HEADER + shipId] = static_cast<unsigned char>(g.shipLength(shipId));
+
+    // A new file is all zeros
+    static const unsigned char empty[4] = {};
+    if (memcmp(base, empty, 4) == 0)
+        memcpy(base, header, HEADER + nShips);
+    else if (memcmp(base, header, HEADER + nShips) != 0)
+    {
+        m_file.close();
+        return false;
+    }
+
+    m_rows = g.rows();
+    m_cols = g.cols();
+    m_lengths.clear();
+    for (int shipId = 0; shipId < nShips; shipId++)
+        m_lengths.push_back(g.shipLength(shipId));
+    m_games = reinterpret_cast<uint32_t*>(base + offset - sizeof(uint32_t));
+    m_counts = reinterpret_cast<uint32_t*>(base + offset);
+    m_shots = m_counts + nShips * 2 * MAXCELLS;
+    return true;
+}
+
+void OpponentModel::close()
+{
+    m_file.close();
+    m_games = nullptr;
+    m_counts = nullptr;
+    m_shots = nullptr;
+}
+
+uint32_t OpponentModel::games() const
+{
+    return m_games == nullptr ? 0 : shared(m_games).load(memory_order_relaxed);
+}
+
+uint32_t OpponentModel::count(int shipId, Direction dir, int cell) const
+{
+    return shared(m_counts + (shipId * 2 + dir) * MAXCELLS + cell).load(memory_order_relaxed);
+}
+
+//####################
+// One increment per ship, and per cell among
+// the player's first EARLY_SHOTS valid shots
+//####################
+void OpponentModel::record(const GameRecord& rec, int who)
+{
+    if (m_counts == nullptr || who < 0 || who > 1 ||
+        rec.placements[who].size() != m_lengths.size())
+        return;
+    for (size_t shipId = 0; shipId < m_lengths.size(); shipId++)
+    {
+        const GameRecord::Placement& pl = rec.placements[who][shipId];
+        int cell = cellIndex(pl.topOrLeft);
+        if (cell >= 0 && cell < MAXCELLS)
+            shared(m_counts + (shipId * 2 + pl.dir) * MAXCELLS + cell).fetch_add(1, memory_order_relaxed);
+    }
+    int nEarly = 0;
+    for (const GameRecord::Shot& shot : rec.shots)
+    {
+        if (shot.who != who || !shot.valid)
+            continue;
+        shared(m_shots + cellIndex(shot.p)).fetch_add(1, memory_order_relaxed);
+        if (++nEarly == EARLY_SHOTS)
+            break;
+    }
+    shared(m_games).fetch_add(1, memory_order_relaxed);
+}
+
+//####################
+// Smoothed share of games each cell held a ship, or was
+// fired at early, over its share under uniform play
+//
+// Each is an expected number per game of ships on the
+// cell or early shots at it; the observed one starts
+// from PRIOR_GAMES uniform games
+//####################
+void OpponentModel::prior(OpponentPrior& out) const
+{
+    for (int cell = 0; cell < MAXCELLS; cell++)
+    {
+        out.placements[cell] = PRIOR_ONE;
+        out.earlyShots[cell] = PRIOR_ONE;
+    }
+    if (m_counts == nullptr)
+        return;
+
+    double uniform[MAXCELLS] = {};
+    double observed[MAXCELLS] = {};
+    int cells[MAXLENGTH];
+    for (size_t shipId = 0; shipId < m_lengths.size(); shipId++)
+    {
+        int length = m_lengths[shipId];
+        int nPlaces = 0;
+        for (int pass = 0; pass < 2; pass++)
+            for (int r = 0; r < m_rows; r++)
+                for (int c = 0; c < m_cols; c++)
+                    for (int d = 0; d < 2; d++)
+                    {
+                        Direction dir = static_cast<Direction>(d);
+                        int n = shipCells(Point(r, c), length, dir, m_rows, m_cols, cells);
+                        if (n == 0)
+                            continue;
+                        if (pass == 0)
+                        {
+                            nPlaces++;
+                            continue;
+                        }
+                        uint32_t seen = count(static_cast<int>(shipId), dir, cellIndex(Point(r, c)));
+                        for (int i = 0; i < n; i++)
+                        {
+                            uniform[cells[i]] += 1.0 / nPlaces;
+                            observed[cells[i]] += seen;
+                        }
+                    }
+    }
+
+    double n = games();
+    double evenShots = double(EARLY_SHOTS) / (m_rows * m_cols);
+    for (int r = 0; r < m_rows; r++)
+        for (int c = 0; c < m_cols; c++)
+        {
+            int cell = cellIndex(Point(r, c));
+            if (uniform[cell] > 0)
+                out.placements[cell] = weight(observed[cell], uniform[cell], n);
+            uint32_t shots = shared(m_shots + cell).load(memory_order_relaxed);
+            out.earlyShots[cell] = weight(shots, evenShots, n);
+        }
+}
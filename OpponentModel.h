@@ -0,0 +1,79 @@
+#ifndef OPPONENTMODEL_INCLUDED
+#define OPPONENTMODEL_INCLUDED
+
+#include "globals.h"
+#include "utility.h"
+#include "GameRecord.h"
+#include <string>
+#include <cstdint>
+#include <vector>
+
+class Game;
+
+  // Weights multiplying a density map cell by cell;
+  // PRIOR_ONE leaves a cell as it was
+const int PRIOR_ONE = 256;
+
+  // Shots per game that count as early: the opening hunt, before
+  // a strategy has much to go on (see EARLY_HUNT in Histogram.h)
+const int EARLY_SHOTS = 20;
+
+  // What a player has learned about this game's opponent
+struct OpponentPrior
+{
+    int placements[MAXCELLS];  // where it puts ships, indexed by cellIndex,
+                               // each at least 1
+    int earlyShots[MAXCELLS];  // where it fires its first EARLY_SHOTS shots,
+                               // PRIOR_ONE being an even spread, each at least 1
+    int candidates;            // fleets to sample when placing against it
+                               // (see GoodPlayer::placeShips); 1 or less
+                               // places at random
+};
+
+  // How one opponent plays, learned over many games
+  //
+  // For every ship and direction the model counts how often each cell
+  // held the ship's top or left end, and for every cell how often the
+  // opponent fired at it among its first EARLY_SHOTS shots. The counts
+  // live in a small file (4 bytes per ship, direction and cell, then 4
+  // per cell, after a short header, in the machine's byte order) mapped
+  // shared, so tournaments on many threads or processes add to one
+  // model at once; recording a game is one atomic increment per ship
+  // and early shot.
+class OpponentModel
+{
+  public:
+      // Pseudo-games of uniform play the prior starts from
+    static const int PRIOR_GAMES = 8;
+
+    OpponentModel();
+      // Maps path, creating it for g's board size and fleet
+      // Returns false if it can't be written or is for another board or fleet
+    bool open(const std::string& path, const Game& g);
+    void close();
+    bool isOpen() const { return m_counts != nullptr; }
+    std::uint32_t games() const;
+
+      // Adds the placements and early shots of player who (0 for
+      // the player who moved first) in one game
+    void record(const GameRecord& rec, int who);
+
+      // How much likelier than under uniform play each cell is to hold
+      // a ship, and to be fired at early, scaled by PRIOR_ONE; all
+      // PRIOR_ONE before any games, and moving toward the opponent's
+      // habits as games are recorded. Leaves out.candidates alone.
+    void prior(OpponentPrior& out) const;
+
+  private:
+    std::uint32_t count(int shipId, Direction dir, int cell) const;
+
+    MappedFile m_file;
+    int m_rows;
+    int m_cols;
+    std::vector<int> m_lengths;
+    std::uint32_t* m_games;
+    std::uint32_t* m_counts;  // [shipId][dir][cell]
+    std::uint32_t* m_shots;   // [cell]
+};
+
+#endif // OPPONENTMODEL_INCLUDED
@@ -2,15 +2,51 @@
 #include "Board.h"
 #include "Game.h"
 #include "globals.h"
+#include "Capture.h"
+#include "OpponentModel.h"
+#include "GoodTuned.h"
 #include "utility.h"
 #include <iostream>
 #include <algorithm>
 #include <string>
 #include <iomanip>
 #include <list>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <vector>
 
 using namespace std;
 
+//*********************************************************************
+//  Player
+//*********************************************************************
+
+//##################
+// Default salvo: asks for one attack per shot,
+// skipping repeats since no results arrive in between
+//##################
+int Player::recommendAttacks(Point* shots, int* scores, int k)
+{
+    int n = 0;
+    for (int tries = 0; n < k && tries < 4 * k; tries++)
+    {
+        Point p = recommendAttack();
+        bool repeated = false;
+        for (int i = 0; i < n; i++)
+            if (shots[i].r == p.r && shots[i].c == p.c)
+                repeated = true;
+        if (repeated)
+            continue;
+        shots[n] = p;
+        scores[n] = 0;
+        n++;
+    }
+    return n;
+}
+
 //*********************************************************************
 //  AwfulPlayer
 //*********************************************************************
@@ -24,6 +60,8 @@ class AwfulPlayer : public Player
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
                                                 bool shipDestroyed, int shipId);
     virtual void recordAttackByOpponent(Point p);
+    virtual void saveState(ostream& out) const;
+    virtual bool loadState(istream& in);
   private:
     Point m_lastCellAttacked;
 };
@@ -66,6 +104,16 @@ void AwfulPlayer::recordAttackByOpponent(Point p)
       // AwfulPlayer completely ignores what the opponent does
 }
 
+void AwfulPlayer::saveState(ostream& out) const
+{
+    out << m_lastCellAttacked.r << ' ' << m_lastCellAttacked.c;
+}
+
+bool AwfulPlayer::loadState(istream& in)
+{
+    return static_cast<bool>(in >> m_lastCellAttacked.r >> m_lastCellAttacked.c);
+}
+
 //*********************************************************************
 //  HumanPlayer
 //*********************************************************************
@@ -190,6 +238,8 @@ public:
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
         bool shipDestroyed, int shipId);
     virtual void recordAttackByOpponent(Point p) { } // Ignores attack by opponent
+    virtual void saveState(ostream& out) const;
+    virtual bool loadState(istream& in);
 
 private:
     bool recursivePlace(Board& b, int shipId);
@@ -214,6 +264,10 @@ bool MediocrePlayer::recursivePlace(Board& b, int shipId)
     // If all ships placed, return true
     if (shipId == game().nShips())
         return true;
+
+    // Backtracking can take exponential time; give up when the game says so
+    if (game().outOfTime())
+        return false;
     
     // Loop through all possible positions, attempting to place at each
     for (int r = 0; r < game().rows(); r++)
@@ -293,8 +347,9 @@ Point MediocrePlayer::recommendAttack()
     //=============================
     if (m_moveState == 1)
     {
-        // Keep trying to find unchosen point
-        while (true)
+        // Try a bounded number of random points
+        int nCells = game().rows() * game().cols();
+        for (int i = 0; i < 2 * nCells; i++)
         {
             Point randomPoint = game().randomPoint();
 
@@ -305,6 +360,21 @@ Point MediocrePlayer::recommendAttack()
                 return randomPoint;
             }
         }
+
+        // Few points left: take the first unchosen one
+        for (int r = 0; r < game().rows(); r++)
+            for (int c = 0; c < game().cols(); c++)
+            {
+                Point p(r, c);
+                if (pointNotChosen(p))
+                {
+                    prevAttacks.push_back(p);
+                    return p;
+                }
+            }
+
+        // Every point already chosen
+        return Point();
     }
 
     //===========================================
@@ -315,13 +385,12 @@ Point MediocrePlayer::recommendAttack()
     if (m_moveState == 2)
     {
         // Check if game has ship lengths of 6+
-        for (int i = 0; i < game().nShips(); i++)
-            if (game().shipLength(i) >= 6)
-            {
-                // Switch to Move State 1
-                m_moveState = 1;
-                return recommendAttack();
-            }
+        if (game().fleet().maxAll >= 6)
+        {
+            // Switch to Move State 1
+            m_moveState = 1;
+            return recommendAttack();
+        }
 
         // Find all possible points in crosshair (up to 4 steps away)
         vector<Point> crosshairPoints;
@@ -340,6 +409,13 @@ Point MediocrePlayer::recommendAttack()
                 crosshairPoints.push_back(horizontalPoint);
         }
 
+        // Crosshair exhausted, switch to Move State 1
+        if (crosshairPoints.empty())
+        {
+            m_moveState = 1;
+            return recommendAttack();
+        }
+
         // Return random point from valid crosshair
         Point randomPoint = crosshairPoints[randInt(crosshairPoints.size())];
         prevAttacks.push_back(randomPoint);
@@ -369,63 +445,368 @@ void MediocrePlayer::recordAttackResult(Point p, bool validShot, bool shotHit, b
     }
 }
 
+//##################
+// Move state, transition point, then previous attacks in order
+//##################
+void MediocrePlayer::saveState(ostream& out) const
+{
+    out << m_moveState << ' ' << transitionPoint.r << ' ' << transitionPoint.c << ' ' << prevAttacks.size();
+    for (const Point& p : prevAttacks)
+        out << ' ' << p.r << ' ' << p.c;
+}
+
+bool MediocrePlayer::loadState(istream& in)
+{
+    size_t nAttacks;
+    if (!(in >> m_moveState >> transitionPoint.r >> transitionPoint.c >> nAttacks) ||
+        (m_moveState != 1 && m_moveState != 2))
+        return false;
+    prevAttacks.clear();
+    for (size_t n = 0; n < nAttacks; n++)
+    {
+        Point p;
+        if (!(in >> p.r >> p.c))
+            return false;
+        prevAttacks.push_back(p);
+    }
+    return true;
+}
+
+//*********************************************************************
+//  Speculation
+//*********************************************************************
+
+// Background worker that computes a player's next move
+// while the opponent takes its turn
+// 
+// The owner must call cancel() before changing any state
+// the computation reads, and start() once it is done
+class Speculation
+{
+  public:
+    Speculation(function<Point()> compute);
+    ~Speculation();
+    void start();
+    void cancel();
+    bool take(Point& p);
+    void report(ostream& out) const;
+
+  private:
+    void run();
+
+    enum State
+    {
+        IDLE,       // nothing computed for the current state
+        REQUESTED,  // worker asked to compute
+        RUNNING,    // worker computing
+        DONE        // result ready
+    };
+
+    function<Point()> m_compute;
+    mutex m_lock;
+    condition_variable m_wake;
+    State m_state;
+    bool m_quit;
+    Point m_result;
+    double m_computeMs;
+
+    // Metrics: moves asked for, moves served by the worker,
+    // and compute time the caller did not have to wait for
+    int m_moves;
+    int m_hits;
+    double m_savedMs;
+
+    thread m_thread;
+};
+
+Speculation::Speculation(function<Point()> compute)
+ : m_compute(compute), m_state(IDLE), m_quit(false), m_computeMs(0),
+   m_moves(0), m_hits(0), m_savedMs(0), m_thread(&Speculation::run, this)
+{}
+
+Speculation::~Speculation()
+{
+    {
+        lock_guard<mutex> lock(m_lock);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+}
+
+//##################
+// Worker loop: computes once per request
+//##################
+void Speculation::run()
+{
+    unique_lock<mutex> lock(m_lock);
+    while (true)
+    {
+        m_wake.wait(lock, [this] { return m_quit || m_state == REQUESTED; });
+        if (m_quit)
+            return;
+
+        m_state = RUNNING;
+        lock.unlock();
+        Timer timer;
+        Point result = m_compute();
+        double ms = timer.elapsed();
+        lock.lock();
+
+        m_result = result;
+        m_computeMs = ms;
+        m_state = DONE;
+        m_wake.notify_all();
+    }
+}
+
+//##################
+// Starts computing the next move from the current state
+//##################
+void Speculation::start()
+{
+    {
+        lock_guard<mutex> lock(m_lock);
+        m_state = REQUESTED;
+    }
+    m_wake.notify_all();
+}
+
+//##################
+// Discards any speculation, waiting for the worker
+// to stop reading state if it is mid-computation
+//##################
+void Speculation::cancel()
+{
+    unique_lock<mutex> lock(m_lock);
+    m_wake.wait(lock, [this] { return m_state != RUNNING; });
+    m_state = IDLE;
+}
+
+//##################
+// Hands over the speculated move, waiting for it if needed
+// Returns false if nothing was speculated for this state
+//##################
+bool Speculation::take(Point& p)
+{
+    Timer timer;
+    unique_lock<mutex> lock(m_lock);
+    m_moves++;
+    if (m_state == IDLE)
+        return false;
+    m_wake.wait(lock, [this] { return m_state == DONE; });
+
+    p = m_result;
+    m_state = IDLE;
+    m_hits++;
+    double waited = timer.elapsed();
+    if (m_computeMs > waited)
+        m_savedMs += m_computeMs - waited;
+    return true;
+}
+
+void Speculation::report(ostream& out) const
+{
+    out << "speculation: " << m_hits << "/" << m_moves << " moves served ("
+        << fixed << setprecision(1) << (m_moves > 0 ? 100.0 * m_hits / m_moves : 0) << "% hit rate), "
+        << setprecision(2) << (m_moves > 0 ? 1000 * m_savedMs / m_moves : 0)
+        << " us saved per move" << endl;
+}
+
 //*********************************************************************
 //  GoodPlayer
 //*********************************************************************
 
+// Probability density for every point on the enemy's board
+typedef int DensityMap[MAXROWS][MAXCOLS];
+
+// Density is recomputed from scratch on every recommendAttack, so it
+// lives in one buffer per thread instead of one per GoodPlayer
+thread_local DensityMap probArray;
+
+// Marks an unused cell index
+const unsigned char NO_CELL = 0xFF;
+
+static int rolloutShots(const Game& g, const Point* starts, const Direction* dirs,
+                        const Timer& timer, double limitMs);
+
 class GoodPlayer : public Player
 {
 public:
-    GoodPlayer(string nm, const Game& g);
+    GoodPlayer(string nm, const Game& g, bool speculative = false, bool sturdy = false,
+               const GoodParams& params = TUNED_GOOD_PARAMS);
+    virtual ~GoodPlayer();
     virtual bool placeShips(Board& b);
     virtual Point recommendAttack();
+    virtual int recommendAttacks(Point* shots, int* scores, int k);
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
         bool shipDestroyed, int shipId);
     virtual void recordAttackByOpponent(Point p) { } // Ignores attack by opponent
+    virtual void reportStats(ostream& out) const;
+    virtual void saveState(ostream& out) const;
+    virtual bool loadState(istream& in);
+    virtual bool densityMap(int* density, Point& best);
+    virtual double hitProbability() const;
+    virtual void useOpponentPrior(const OpponentPrior* prior);
 
 private:
-    bool validPoint(Point p);
-    bool validPlace(Point p, int shipId, Direction dir);
+    Point bestAttack();
+    bool validPoint(Point p) const;
+    int topCells(Point* shots, int* scores, int n, int k);
+    bool validPlace(Point p, int shipId, Direction dir) const;
     bool recursivePlace(Board& b, int shipId);
+    bool leastExposedPlace(Board& b);
     void resetProbArray();
-    void printProbArray();
     void huntProb();
     void targetProb();
+    double targetHitProbability(Point p) const;
+    void applyPrior();
+    void retarget();
+    void updateKnowledge(Point p, bool shotHit, bool shipDestroyed, int shipId);
+
+    // Rollouts drive a GoodPlayer without the capture and
+    // speculation recommendAttack and recordAttackResult bring
+    friend int rolloutShots(const Game& g, const Point* starts, const Direction* dirs,
+                            const Timer& timer, double limitMs);
 
-    enum AttackMode
+    enum AttackMode : unsigned char
     {
         HUNT,
         TARGET
     };
 
+    // Byte budget (64-bit, 10x10 board):
+    //   Player base (vptr, name, game)   48
+    //   m_missed, m_destroyed, shipsAlive 3 x 16
+    //   m_target, m_second, m_attackMode,
+    //   m_sturdy                           4
+    //   m_params, m_chosen                 4
+    //   m_captureId, m_hitProbability     8
+    //   m_prior, m_speculation            16
+    // Total 128 bytes: two cache lines, checked below the class
+
     // Stores missed shots (or already destroyed ship points)
-    vector<Point> m_missed;
+    Bitboard m_missed;
 
     // Stores hits that aren't fully destroyed ships
-    vector<Point> m_destroyed;
+    Bitboard m_destroyed;
 
-    // Stores the enemy's undestroyed ships
-    vector<ShipType> shipsAlive;
+    // Stores the enemy's undestroyed ship ids (every ship
+    // covers at least one cell, so MAXCELLS bits always suffice)
+    Bitboard shipsAlive;
+
+    // Cell index of the hit that started TARGET mode
+    unsigned char m_target;
+
+    // Cell index of the next hit after m_target (or NO_CELL)
+    unsigned char m_second;
 
     // Attacking mode for recommending a point
     // HUNT or TARGET
     AttackMode m_attackMode;
 
-    // Stores probability density array for every point on enemy's board
-    int probArray[MAXROWS][MAXCOLS];
+    // Places the fleet that survives rollouts longest (see placeSturdyFleet)
+    bool m_sturdy;
+
+    // Constants the density maps are built with
+    GoodParams m_params;
+
+    // Cell index of the move bestAttack chose from a TARGET map,
+    // whose hit probability is only worked out if asked for
+    // (or NO_CELL)
+    unsigned char m_chosen;
+
+    // Tags this player's moves in a density capture (see Capture.h);
+    // 0 keeps them out of it
+    unsigned m_captureId;
+
+    // Hit probability of the last move bestAttack chose
+    // from a HUNT map
+    float m_hitProbability;
+
+    // Where this opponent tends to place ships and fire early (optional)
+    const OpponentPrior* m_prior;
+
+    // Computes the next move during the opponent's turn (optional)
+    Speculation* m_speculation;
 };
 
+static_assert(sizeof(GoodPlayer) <= 128, "GoodPlayer must fit in two cache lines");
+
 //#####################
 // GoodPlayer starts out in HUNT mode
 //#####################
-GoodPlayer::GoodPlayer(string nm, const Game& g) : Player(nm, g), m_attackMode(HUNT)
+GoodPlayer::GoodPlayer(string nm, const Game& g, bool speculative, bool sturdy, const GoodParams& params)
+ : Player(nm, g), m_target(NO_CELL), m_second(NO_CELL), m_attackMode(HUNT), m_sturdy(sturdy), m_params(params),
+   m_chosen(NO_CELL), m_captureId(newCaptureId()), m_hitProbability(0), m_prior(nullptr), m_speculation(nullptr)
 { 
-    // Sets probability array to all 0s
-    resetProbArray();
-
     // Store starting ship types
     for (int n = 0; n < g.nShips(); n++)
-        shipsAlive.push_back(ShipType(g.shipLength(n), g.shipSymbol(n), g.shipName(n)));
+        shipsAlive.set(n);
+
+    // Start on the first move right away; a capture needs the
+    // map in the caller's thread, so it would go to waste
+    if (speculative)
+    {
+        m_speculation = new Speculation([this] { return bestAttack(); });
+        if (!capturing())
+            m_speculation->start();
+    }
+}
+
+GoodPlayer::~GoodPlayer()
+{
+    delete m_speculation;
+}
+
+void GoodPlayer::reportStats(ostream& out) const
+{
+    if (m_speculation != nullptr)
+        m_speculation->report(out);
+}
+
+//##################
+// The speculated first move was computed without the
+// prior, so it is dropped and started over
+//##################
+void GoodPlayer::useOpponentPrior(const OpponentPrior* prior)
+{
+    if (m_speculation != nullptr)
+        m_speculation->cancel();
+    m_prior = prior;
+    if (m_speculation != nullptr && !capturing())
+        m_speculation->start();
+}
+
+//##################
+// Knowledge sets as bit strings, then the target cells and mode
+//##################
+void GoodPlayer::saveState(ostream& out) const
+{
+    out << m_missed << ' ' << m_destroyed << ' ' << shipsAlive << ' '
+        << int(m_target) << ' ' << int(m_second) << ' ' << int(m_attackMode);
+}
+
+//##################
+// Any speculated move was computed from the old
+// state, so it is dropped and started over
+//##################
+bool GoodPlayer::loadState(istream& in)
+{
+    if (m_speculation != nullptr)
+        m_speculation->cancel();
+    int target, second, mode;
+    bool ok = in >> m_missed >> m_destroyed >> shipsAlive >> target >> second >> mode &&
+              mode >= HUNT && mode <= TARGET;
+    if (ok)
+    {
+        m_target = static_cast<unsigned char>(target);
+        m_second = static_cast<unsigned char>(second);
+        m_attackMode = static_cast<AttackMode>(mode);
+    }
+    if (m_speculation != nullptr && !capturing())
+        m_speculation->start();
+    return ok;
 }
 
 //##################
@@ -466,43 +847,220 @@ bool GoodPlayer::recursivePlace(Board& b, int shipId)
 }
 
 //#############
-// Randomly places ships
+// A sturdy player places the fleet that lasted longest in
+// rollouts; otherwise ships go where this opponent seldom
+// fires early, if that's known, or else randomly
 //#############
 bool GoodPlayer::placeShips(Board& b)
 {
+    if (m_sturdy && placeSturdyFleet(b, game(), DEFAULT_ROLLOUT_BUDGET))
+        return true;
+    if (m_prior != nullptr && m_prior->candidates > 1 && leastExposedPlace(b))
+        return true;
     return recursivePlace(b, 0);
 }
 
+//##################
+// Draws a random fleet into starts and dirs, and returns
+// the sum of weights (if any) over the cells it covers,
+// or -1 if the ships would not fit
+//
+// Ships go down in shipId order at uniformly chosen
+// directions and positions, retrying on overlap; the
+// cells are tracked in a Bitboard, so no Board is touched
+//##################
+static long long sampleFleet(const Game& g, const int* weights, Point* starts, Direction* dirs)
+{
+    for (int attempt = 0; attempt < 20; attempt++)
+    {
+        Bitboard used;
+        long long total = 0;
+        int shipId = 0;
+        for ( ; shipId < g.nShips(); shipId++)
+        {
+            int length = g.shipLength(shipId);
+            int tries = 0;
+            for ( ; tries < 50; tries++)
+            {
+                Direction dir = randInt(2) == 0 ? VERTICAL : HORIZONTAL;
+                int dr = dir == VERTICAL ? 1 : 0;
+                int dc = 1 - dr;
+                int nRows = g.rows() - dr * (length - 1);
+                int nCols = g.cols() - dc * (length - 1);
+                if (nRows < 1 || nCols < 1)
+                    return -1;
+                Point p(randInt(nRows), randInt(nCols));
+                int i = 0;
+                while (i < length && !used.test(cellIndex(Point(p.r + dr * i, p.c + dc * i))))
+                    i++;
+                if (i < length)
+                    continue;
+                for (i = 0; i < length; i++)
+                {
+                    int cell = cellIndex(Point(p.r + dr * i, p.c + dc * i));
+                    used.set(cell);
+                    if (weights != nullptr)
+                        total += weights[cell];
+                }
+                starts[shipId] = p;
+                dirs[shipId] = dir;
+                break;
+            }
+            if (tries == 50)
+                break;
+        }
+        if (shipId == g.nShips())
+            return total;
+    }
+    return -1;
+}
+
+//##################
+// Samples m_prior->candidates fleets and places the one
+// least exposed to this opponent's early shots
+//
+// A fleet's exposure is the sum of the opponent's early-shot
+// weights over its cells, in proportion to the hits it can
+// expect in its first EARLY_SHOTS shots if it fires as it has
+// before. A candidate costs about half a microsecond on a
+// 10x10 board; ties keep the first, so with nothing learned
+// the fleet is as random as recursivePlace's.
+//##################
+bool GoodPlayer::leastExposedPlace(Board& b)
+{
+    int nShips = game().nShips();
+    if (nShips > MAXCELLS)
+        return false;
+    Point starts[MAXCELLS];
+    Direction dirs[MAXCELLS];
+    Point bestStarts[MAXCELLS];
+    Direction bestDirs[MAXCELLS];
+    long long best = -1;
+    for (int n = 0; n < m_prior->candidates; n++)
+    {
+        long long exposure = sampleFleet(game(), m_prior->earlyShots, starts, dirs);
+        if (exposure < 0 || (best >= 0 && exposure >= best))
+            continue;
+        best = exposure;
+        copy(starts, starts + nShips, bestStarts);
+        copy(dirs, dirs + nShips, bestDirs);
+    }
+    if (best < 0)
+        return false;
+
+    for (int shipId = 0; shipId < nShips; shipId++)
+        if (!b.placeShip(bestStarts[shipId], shipId, bestDirs[shipId]))
+        {
+            while (--shipId >= 0)
+                b.unplaceShip(bestStarts[shipId], shipId, bestDirs[shipId]);
+            return false;
+        }
+    return true;
+}
+
+//##################
+// Shots a fresh GoodPlayer takes to sink a fleet, or -1 if
+// the fleet can't be placed or timer passes limitMs first
+//
+// GoodPlayer hunts deterministically, so one rollout gives
+// the fleet's exact survival against it
+//##################
+static int rolloutShots(const Game& g, const Point* starts, const Direction* dirs,
+                        const Timer& timer, double limitMs)
+{
+    Board b(g);
+    for (int shipId = 0; shipId < g.nShips(); shipId++)
+        if (!b.placeShip(starts[shipId], shipId, dirs[shipId]))
+            return -1;
+
+    // Rollouts are not the game's moves, so they stay out of any capture
+    GoodPlayer attacker("rollout", g);
+    attacker.m_captureId = 0;
+    bool late = false;
+    int shots = attackUntilSunk(attacker, b, nullptr, [&](const AttackResult&)
+    {
+        late = !b.allShipsDestroyed() && timer.elapsed() > limitMs;
+        return !late;
+    });
+    return late ? -1 : shots;
+}
+
+//##################
+// Draws the candidates, rolls them out on up to
+// budget.nThreads threads, and places the best
+//
+// Candidates are drawn on this thread before any rollout,
+// so the seed alone decides them; the choice is then the
+// seed's too, unless the budget cuts rollouts short
+//##################
+bool placeSturdyFleet(Board& b, const Game& g, const RolloutBudget& budget)
+{
+    int nShips = g.nShips();
+    int nCandidates = max(budget.candidates, 1);
+    vector<Point> starts(nCandidates * nShips);
+    vector<Direction> dirs(nCandidates * nShips);
+    int nDrawn = 0;
+    while (nDrawn < nCandidates &&
+           sampleFleet(g, nullptr, &starts[nDrawn * nShips], &dirs[nDrawn * nShips]) >= 0)
+        nDrawn++;
+    if (nDrawn == 0)
+        return false;
+
+    // Each candidate's result goes in its own slot
+    vector<int> shots(nDrawn, -1);
+    if (nDrawn > 1)
+    {
+        Timer timer;
+        atomic<int> next(0);
+        auto worker = [&]()
+        {
+            for (int n = next++; n < nDrawn; n = next++)
+                shots[n] = rolloutShots(g, &starts[n * nShips], &dirs[n * nShips], timer, budget.ms);
+        };
+        vector<thread> helpers;
+        for (int t = 1; t < min(budget.nThreads, nDrawn); t++)
+            helpers.push_back(thread(worker));
+        worker();
+        for (thread& t : helpers)
+            t.join();
+    }
+
+    // Ties, and a budget too small for any rollout, keep the first
+    int best = 0;
+    for (int n = 1; n < nDrawn; n++)
+        if (shots[n] > shots[best])
+            best = n;
+    const Point* bestStarts = &starts[best * nShips];
+    const Direction* bestDirs = &dirs[best * nShips];
+    for (int shipId = 0; shipId < nShips; shipId++)
+        if (!b.placeShip(bestStarts[shipId], shipId, bestDirs[shipId]))
+        {
+            while (--shipId >= 0)
+                b.unplaceShip(bestStarts[shipId], shipId, bestDirs[shipId]);
+            return false;
+        }
+    return true;
+}
+
 //################
 // Checks if Point is in bounds
 // and was not attacked before
 //################
-bool GoodPlayer::validPoint(Point p)
+bool GoodPlayer::validPoint(Point p) const
 {
     // Point is out of bounds
     if (!game().isValid(p))
         return false;
 
-    // Checks if passed Point pos matches Point p
-    auto matchingPos = [&p](Point pos)
-    {
-        if (p.r == pos.r && p.c == pos.c)
-            return true;
-        return false;
-    };
-
-    // If Point p matches any Point in m_missed, it is invalid
-    if (find_if(m_missed.begin(), m_missed.end(), matchingPos) != m_missed.end())
-        return false;
-
-    return true;
+    // If Point p is in m_missed, it is invalid
+    return !m_missed.test(cellIndex(p));
 }
 
 //#################
 // Checks if able to place a ship
 // length at a point in a direction
 //#################
-bool GoodPlayer::validPlace(Point p, int shipLength, Direction dir)
+bool GoodPlayer::validPlace(Point p, int shipLength, Direction dir) const
 {
     // TopLeft point is invalid
     if (!validPoint(p))
@@ -557,48 +1115,47 @@ void GoodPlayer::resetProbArray()
 void GoodPlayer::huntProb()
 {
     resetProbArray();
+    const Fleet& fleet = game().fleet();
 
     // Add probability density for each ship
-    for (const ShipType& st : shipsAlive)
+    for (int id = 0; id < fleet.nShips; id++)
     {
+        if (!shipsAlive.test(id))
+            continue;
+
+        int length = fleet.lengths[id];
+
         // Loop through all points on the board
         for (int r = 0; r < game().rows(); r++)
             for (int c = 0; c < game().cols(); c++)
             {
                 // Validate placements along vertical crosshair centered at point
-                for (int i = r - st.length + 1; i <= r; i++)
+                for (int i = r - length + 1; i <= r; i++)
                     // Add to probability if able to place particular ship configuration
-                    if (validPlace(Point(i, c), st.length, VERTICAL))
+                    if (validPlace(Point(i, c), length, VERTICAL))
                         probArray[r][c]++;
                 
                 // Validate placements along horizontal crosshair centered at point
-                for (int i = c - st.length + 1; i <= c; i++)
+                for (int i = c - length + 1; i <= c; i++)
                     // Add to probability if able to place particular ship configuration
-                    if (validPlace(Point(r, i), st.length, HORIZONTAL))
+                    if (validPlace(Point(r, i), length, HORIZONTAL))
                         probArray[r][c]++;
             }
     }
 
     // Parity Strategy
-    // Keep every other N (smallest ship length) positions, set others to 0 probability
-
-    // Find smallest ship length
-    int smallestLength = shipsAlive[0].length;
-    for (const ShipType& st : shipsAlive)
-    {
-        if (st.length < smallestLength)
-            smallestLength = st.length;
-    }
-    
-    // Set probability of ships not on parity grid to zero
+    // Keep every Nth position (N the smallest ship length, unless
+    // m_params sets it), set others to 0 probability
+    int stride = m_params.parityStride > 0 ? m_params.parityStride : fleet.minLength(shipsAlive);
     for (int r = 0; r < game().rows(); r++)
     {
         for (int c = 0; c < game().cols(); c++)
         {
-            if (r % smallestLength != c % smallestLength)
+            if (r % stride != c % stride)
                 probArray[r][c] = 0;
         }
     }
+    applyPrior();
 }
 
 //########################
@@ -617,33 +1174,38 @@ void GoodPlayer::targetProb()
 {
     resetProbArray();
 
-    // Find Point that triggered TARGET mode (first Point in m_destroyed)
-    Point target = m_destroyed.front();
+    // Find Point that triggered TARGET mode
+    Point target(m_target / MAXCOLS, m_target % MAXCOLS);
     int row = target.r;
     int col = target.c;
 
     // Calculate probability of each ship along crosshair centered at Point
-    for (ShipType& st : shipsAlive)
+    const Fleet& fleet = game().fleet();
+    for (int id = 0; id < fleet.nShips; id++)
     {
+            if (!shipsAlive.test(id))
+                continue;
+            int length = fleet.lengths[id];
+
             // For each possible ship placement position in vertical crosshair
-            for (int i = row - st.length + 1; i <= row; i++)
+            for (int i = row - length + 1; i <= row; i++)
                 // If able to place a ship vertically
                 // Add 1 to all points along ship placement path
-                if (validPlace(Point(i, col), st.length, VERTICAL))
+                if (validPlace(Point(i, col), length, VERTICAL))
                 {
-                    for (int r = i; r < i + st.length; r++)
+                    for (int r = i; r < i + length; r++)
                     {
                         probArray[r][col]++;
                     }
                 }
 
             // For each possible ship placement position in horizontal crosshair
-            for (int i = col - st.length + 1; i <= col; i++)
+            for (int i = col - length + 1; i <= col; i++)
                 // If able to place a ship horizontally
                 // Add 1 to all points along ship placement path
-                if (validPlace(Point(row, i), st.length, HORIZONTAL))
+                if (validPlace(Point(row, i), length, HORIZONTAL))
                 {
-                    for (int c = i; c < i + st.length; c++)
+                    for (int c = i; c < i + length; c++)
                     {
                         probArray[row][c]++;
                     }
@@ -652,41 +1214,126 @@ void GoodPlayer::targetProb()
 
     // If there are at least 2 hit points (forming a line)
     // increase weights for the points on the line
-    if (m_destroyed.size() >= 2)
+    if (m_second != NO_CELL)
     {
+        Point second(m_second / MAXCOLS, m_second % MAXCOLS);
+
         // Both points are on same row
-        if (target.r == m_destroyed[1].r)
+        if (target.r == second.r)
         {
             // Loop through all points on same row
             for (int i = 0; i < game().cols(); i++)
             {
-                // Double weights on point
-                probArray[target.r][i] *= 2;
+                // Weight points on the line
+                probArray[target.r][i] *= m_params.lineWeight;
 
                 // Increase weights based on proximity to target point
                 if (i != target.c)
-                    probArray[target.r][i] *= 10 / abs(i - target.c);
+                    probArray[target.r][i] *= m_params.proximity / abs(i - target.c);
             }
         }
 
         // Both points are on same column
-        if (target.c == m_destroyed[1].c)
+        if (target.c == second.c)
         {
             // Loop through all points on same column
             for (int i = 0; i < game().rows(); i++)
             {
-                // Double weights on point
-                probArray[i][target.c] *= 2;
+                // Weight points on the line
+                probArray[i][target.c] *= m_params.lineWeight;
 
                 // Increase weights based on proximity to target point
                 if (i != target.r)
-                    probArray[i][target.c] *= 10 / abs(i - target.r);
+                    probArray[i][target.c] *= m_params.proximity / abs(i - target.r);
             }
         }
     }
     // Set destroyed spot to 0 probability
-    for (const Point& p : m_destroyed)
-        probArray[p.r][p.c] = 0;
+    for (int r = 0; r < game().rows(); r++)
+        for (int c = 0; c < game().cols(); c++)
+            if (m_destroyed.test(cellIndex(Point(r, c))))
+                probArray[r][c] = 0;
+    applyPrior();
+}
+
+//########################
+// Odds that the last move bestAttack chose hits; called
+// before the move's result is recorded
+//########################
+double GoodPlayer::hitProbability() const
+{
+    if (m_chosen == NO_CELL)
+        return m_hitProbability;
+    return targetHitProbability(Point(m_chosen / MAXCOLS, m_chosen % MAXCOLS));
+}
+
+//########################
+// Share of the placements of ships afloat through the
+// target that cover p, counting only those through the
+// second hit as well if any of them cover p (a p off
+// their line belongs to a ship beside them)
+//
+// A placement on hits alone is left out, as that ship
+// would have sunk
+//########################
+double GoodPlayer::targetHitProbability(Point p) const
+{
+    Point target(m_target / MAXCOLS, m_target % MAXCOLS);
+    Point second = m_second != NO_CELL ? Point(m_second / MAXCOLS, m_second % MAXCOLS) : target;
+
+    // [0] every placement through the target, [1] those also through second
+    int through[2] = { 0, 0 };
+    int covering[2] = { 0, 0 };
+    const Fleet& fleet = game().fleet();
+    for (int id = 0; id < fleet.nShips; id++)
+    {
+        if (!shipsAlive.test(id))
+            continue;
+        int length = fleet.lengths[id];
+        for (Direction dir : { VERTICAL, HORIZONTAL })
+        {
+            int dr = dir == VERTICAL ? 1 : 0;
+            int dc = 1 - dr;
+            for (int i = 0; i < length; i++)
+            {
+                Point start(target.r - i * dr, target.c - i * dc);
+                if (!validPlace(start, length, dir))
+                    continue;
+                bool coversP = false;
+                bool coversSecond = false;
+                bool allHit = true;
+                for (int j = 0; j < length; j++)
+                {
+                    Point q(start.r + j * dr, start.c + j * dc);
+                    coversP = coversP || (q.r == p.r && q.c == p.c);
+                    coversSecond = coversSecond || (q.r == second.r && q.c == second.c);
+                    allHit = allHit && m_destroyed.test(cellIndex(q));
+                }
+                if (allHit)
+                    continue;
+                through[0]++;
+                covering[0] += coversP;
+                through[1] += coversSecond;
+                covering[1] += coversSecond && coversP;
+            }
+        }
+    }
+
+    int k = covering[1] > 0 ? 1 : 0;
+    return through[k] > 0 ? double(covering[k]) / through[k] : 0;
+}
+
+//########################
+// Weights the density by where this opponent has
+// placed ships in past games, if known
+//########################
+void GoodPlayer::applyPrior()
+{
+    if (m_prior == nullptr)
+        return;
+    for (int r = 0; r < game().rows(); r++)
+        for (int c = 0; c < game().cols(); c++)
+            probArray[r][c] *= m_prior->placements[cellIndex(Point(r, c))];
 }
 
 //#############################
@@ -694,9 +1341,36 @@ void GoodPlayer::targetProb()
 // Returns point with highest probability in the array
 //#############################
 Point GoodPlayer::recommendAttack()
+{
+    // Use the move worked out during the opponent's turn, unless
+    // capturing, which needs the map in this thread's probArray;
+    // a worker started before the capture must stop first, as
+    // bestAttack writes m_hitProbability
+    Point best;
+    if (m_speculation != nullptr)
+    {
+        if (!capturing() && m_speculation->take(best))
+            return best;
+        m_speculation->cancel();
+    }
+    best = bestAttack();
+    if (capturing() && m_captureId != 0)
+        captureChoice(m_captureId, static_cast<int>((m_missed | m_destroyed).count()), m_attackMode,
+                      &probArray[0][0], best, game().rows(), game().cols());
+    return best;
+}
+
+//#############################
+// Computes the best attack from current knowledge
+// 
+// Only reads player state (besides noting the move's
+// hit probability), so it may run on the speculation
+// worker
+//#############################
+Point GoodPlayer::bestAttack()
 {
     // No ships left
-    if (shipsAlive.empty())
+    if (shipsAlive.none())
         return Point();
 
     // Calculate HUNT probabilities
@@ -704,16 +1378,38 @@ Point GoodPlayer::recommendAttack()
         huntProb();
 
     // Calculate TARGET probabilities
-    if (m_attackMode == TARGET)
+    bool targeting = m_attackMode == TARGET;
+    if (targeting)
+    {
         targetProb();
 
+        // Touching ships can leave no room around the target for any
+        // ship afloat (the sunk one's cells were deduced wrongly), so
+        // hunt among the cells not hit yet rather than fire at nothing
+        bool empty = true;
+        for (int r = 0; r < game().rows() && empty; r++)
+            for (int c = 0; c < game().cols() && empty; c++)
+                empty = probArray[r][c] == 0;
+        if (empty)
+        {
+            targeting = false;
+            huntProb();
+            for (int r = 0; r < game().rows(); r++)
+                for (int c = 0; c < game().cols(); c++)
+                    if (m_destroyed.test(cellIndex(Point(r, c))))
+                        probArray[r][c] = 0;
+        }
+    }
+
     // Return point with highest value (probability) in probArray
     int maxProb = 0;
+    long long total = 0;
     Point best;
     for (int r = 0; r < game().rows(); r++)
     {
         for (int c = 0; c < game().cols(); c++)
         {
+            total += probArray[r][c];
             if (probArray[r][c] > maxProb)
             {
                 maxProb = probArray[r][c];
@@ -723,51 +1419,221 @@ Point GoodPlayer::recommendAttack()
         }
     }
 
+    // Nothing scored, so take the first cell not fired at
+    if (maxProb == 0)
+    {
+        Bitboard fired = m_missed | m_destroyed;
+        bool found = false;
+        for (int r = 0; r < game().rows() && !found; r++)
+            for (int c = 0; c < game().cols() && !found; c++)
+                if (!fired.test(cellIndex(Point(r, c))))
+                {
+                    best = Point(r, c);
+                    found = true;
+                }
+    }
+
+    // As a hit probability: a hunting map's total stands for the
+    // cells of ships afloat that are not hit yet, but a targeting
+    // map only scores the crosshair, so hitProbability counts its
+    // placements out instead
+    m_chosen = targeting ? static_cast<unsigned char>(cellIndex(best)) : NO_CELL;
+    int unhit = -static_cast<int>(m_destroyed.count());
+    for (int id = 0; id < game().nShips(); id++)
+        if (shipsAlive.test(id))
+            unhit += game().fleet().lengths[id];
+    double prob = total > 0 ? double(maxProb) * unhit / total : 0;
+    m_hitProbability = static_cast<float>(prob < 1 ? prob : 1);
+
     return best;
 }
 
 //#############################
-// Calculates probability density based on attack mode
-// Returns point with highest probability in the array
+// Copies out the density bestAttack works from
+//#############################
+bool GoodPlayer::densityMap(int* density, Point& best)
+{
+    resetProbArray();
+    best = bestAttack();
+    for (int r = 0; r < MAXROWS; r++)
+        for (int c = 0; c < MAXCOLS; c++)
+            density[cellIndex(Point(r, c))] = probArray[r][c];
+    return true;
+}
+
+//#############################
+// Inserts the best cells of probArray into the sorted
+// first n entries of shots/scores, keeping at most k
+// Returns the new count
+//#############################
+int GoodPlayer::topCells(Point* shots, int* scores, int n, int k)
+{
+    for (int r = 0; r < game().rows(); r++)
+    {
+        for (int c = 0; c < game().cols(); c++)
+        {
+            int prob = probArray[r][c];
+            if (prob <= 0 || (n == k && prob <= scores[n - 1]))
+                continue;
+
+            // Skip cells already chosen
+            bool chosen = false;
+            for (int i = 0; i < n; i++)
+                if (shots[i].r == r && shots[i].c == c)
+                    chosen = true;
+            if (chosen)
+                continue;
+
+            // Insertion sort, highest score first
+            int i = n < k ? n++ : n - 1;
+            while (i > 0 && scores[i - 1] < prob)
+            {
+                shots[i] = shots[i - 1];
+                scores[i] = scores[i - 1];
+                i--;
+            }
+            shots[i] = Point(r, c);
+            scores[i] = prob;
+        }
+    }
+    return n;
+}
+
+//#############################
+// Salvo: returns the k highest-probability cells
+// 
+// TARGET mode only scores the crosshair, so if it runs
+// out of cells the rest of the salvo comes from HUNT
+//#############################
+int GoodPlayer::recommendAttacks(Point* shots, int* scores, int k)
+{
+    if (shipsAlive.none() || k < 1)
+        return 0;
+
+    // Salvos are not speculated
+    if (m_speculation != nullptr)
+        m_speculation->cancel();
+
+    if (m_attackMode == HUNT)
+        huntProb();
+    else
+        targetProb();
+    int n = topCells(shots, scores, 0, k);
+
+    if (n < k && m_attackMode == TARGET)
+    {
+        // Hunt picks follow every target pick, skipping cells
+        // already chosen or already hit
+        int nTarget = n;
+        huntProb();
+        for (int i = 0; i < nTarget; i++)
+            probArray[shots[i].r][shots[i].c] = 0;
+        for (int r = 0; r < game().rows(); r++)
+            for (int c = 0; c < game().cols(); c++)
+                if (m_destroyed.test(cellIndex(Point(r, c))))
+                    probArray[r][c] = 0;
+        n = topCells(shots + nTarget, scores + nTarget, 0, k - nTarget) + nTarget;
+    }
+    return n;
+}
+
+//#############################
+// Picks the earliest remaining hits as the TARGET
+// mode anchor once a sunk ship has consumed them
+//#############################
+void GoodPlayer::retarget()
+{
+    // Switch to HUNT if no positions left in m_destroyed
+    if (m_destroyed.none())
+    {
+        m_attackMode = HUNT;
+        m_target = NO_CELL;
+        m_second = NO_CELL;
+        return;
+    }
+
+    // The second hit is next in line; beyond that hit order
+    // is not kept, so fall back to the lowest remaining cells
+    if (!m_destroyed.test(m_target))
+    {
+        m_target = m_second;
+        m_second = NO_CELL;
+    }
+    if (m_target != NO_CELL && !m_destroyed.test(m_target))
+        m_target = NO_CELL;
+    if (m_second != NO_CELL && !m_destroyed.test(m_second))
+        m_second = NO_CELL;
+    for (int i = 0; i < MAXCELLS && (m_target == NO_CELL || m_second == NO_CELL); i++)
+    {
+        if (!m_destroyed.test(i) || i == m_target || i == m_second)
+            continue;
+        if (m_target == NO_CELL)
+            m_target = i;
+        else
+            m_second = i;
+    }
+}
+
+//#############################
+// Updates knowledge of the enemy's board
+// from the result of an attack
 //#############################
 void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
 {
-    if (shipsAlive.empty())
+    if (capturing())
+        captureResult(m_captureId, validShot, shotHit, shipDestroyed, shipId);
+
+    // Invalid shots reveal nothing
+    if (shipsAlive.none() || !validShot)
         return;
-        
+
+    // Any speculation is stale; restart it once state is updated
+    if (m_speculation != nullptr)
+        m_speculation->cancel();
+    updateKnowledge(p, shotHit, shipDestroyed, shipId);
+    if (m_speculation != nullptr && shipsAlive.any() && !capturing())
+        m_speculation->start();
+}
+
+//#############################
+// Records what an attack revealed about the enemy's board
+//#############################
+void GoodPlayer::updateKnowledge(Point p, bool shotHit, bool shipDestroyed, int shipId)
+{
+
+    int cell = cellIndex(p);
+
     // If hit, switch to targeting mode, add Point to list of destroyed
     if (shotHit)
     {
-        m_destroyed.push_back(p);
+        if (m_destroyed.none())
+            m_target = cell;
+        else if (m_second == NO_CELL)
+            m_second = cell;
+        m_destroyed.set(cell);
         m_attackMode = TARGET;
     }
     // If not, stay in same mode, add Point to list of missed
     else
-        m_missed.push_back(p);
+        m_missed.set(cell);
 
     // If ship was destroyed at Point p:
     // -------------------------------------
-    // 1. Remove ship from vector of remaining ships
+    // 1. Remove ship from set of remaining ships
     // 2. Deduce which positions the ship was located on
     // 3. Move those positions from m_destroyed to m_missed
     // 4. If there are still positions in m_destroyed, stay in TARGET mode
     // 5. If m_destroyed is empty, switch to HUNT mode
     if (shipDestroyed)
     {
-        // Remove destroyed ship from vector
-        for (vector<ShipType>::iterator it = shipsAlive.begin(); it != shipsAlive.end(); )
-        {
-            if (it->symbol == game().shipSymbol(shipId))
-                it = shipsAlive.erase(it);
-            else
-                it++;
-        }
+        // Remove destroyed ship from set
+        shipsAlive.reset(shipId);
 
         // Determine the space where the ship was located
-        Point target = m_destroyed.front();
-        int destroyedShipLength = game().shipLength(shipId);
-        int start = 0;
-        int end = 0;
+        Point target(m_target / MAXCOLS, m_target % MAXCOLS);
+        int destroyedShipLength = game().fleet().lengths[shipId];
+        int start = p.c;
+        int end = p.c + 1;
 
         // Point p is topmost
         if (p.r < target.r)
@@ -797,36 +1663,19 @@ void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool
         // Loop from start to end positions
         for (int i = start; i < end; i++)
         {
-            int r, c;
-
-            // Ship was vertical
-            if (p.c == target.c)
-            {
-                r = i;
-                c = p.c;
-            }
-            // Ship was horizontal
-            else
-            {
-                r = p.r;
-                c = i;
-            }
-
-            // Store destroyed position as a missed position
-            m_missed.push_back(Point(r, c));
+            // Ship was vertical or horizontal
+            Point pos = (p.c == target.c && p.r != target.r) ? Point(i, p.c) : Point(p.r, i);
+            // Only hits can be the sunk ship's; with ships side by side
+            // the range may cross cells never fired at, which must stay open
+            if (!game().isValid(pos) || !m_destroyed.test(cellIndex(pos)))
+                continue;
 
-            // Remove destroyed position from vector
-            for (vector<Point>::iterator it = m_destroyed.begin(); it != m_destroyed.end();)
-            {
-                if ((*it).r == r && (*it).c == c)
-                    it = m_destroyed.erase(it);
-                else
-                    it++;
-            }
+            // Move destroyed position to missed positions
+            m_missed.set(cellIndex(pos));
+            m_destroyed.reset(cellIndex(pos));
         }
-        // Switch to HUNT if no positions left in m_destroyed
-        if (m_destroyed.empty())
-            m_attackMode = HUNT;
+
+        retarget();
     }
 }
 
@@ -837,7 +1686,7 @@ void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool
 Player* createPlayer(string type, string nm, const Game& g)
 {
     static string types[] = {
-        "human", "awful", "mediocre", "good"
+        "human", "awful", "mediocre", "good", "speculative", "sturdy"
     };
     
     int pos;
@@ -850,6 +1699,40 @@ Player* createPlayer(string type, string nm, const Game& g)
       case 1:  return new AwfulPlayer(nm, g);
       case 2:  return new MediocrePlayer(nm, g);
       case 3:  return new GoodPlayer(nm, g);
+      case 4:  return new GoodPlayer(nm, g, true);
+      case 5:  return new GoodPlayer(nm, g, false, true);
       default: return nullptr;
     }
 }
+
+Player* createGoodPlayer(string nm, const Game& g, const GoodParams& params)
+{
+    return new GoodPlayer(nm, g, false, false, params);
+}
+
+//#####################
+// The attack loop every simulation shares: p fires at b
+// and learns each result until the fleet is sunk, at most
+// 4 shots per cell
+//#####################
+int attackUntilSunk(Player& p, Board& b, double* chooseUs,
+                    const function<bool(const AttackResult&)>& onShot)
+{
+    const Game& g = p.game();
+    int limit = 4 * g.rows() * g.cols();
+    int shots = 0;
+    while (!b.allShipsDestroyed() && shots < limit)
+    {
+        Timer timer;
+        AttackResult res;
+        res.p = p.recommendAttack();
+        if (chooseUs != nullptr)
+            *chooseUs += timer.elapsed() * 1e3;
+        res.valid = b.attack(res.p, res.shotHit, res.shipDestroyed, res.shipId);
+        p.recordAttackResult(res.p, res.valid, res.shotHit, res.shipDestroyed, res.shipId);
+        shots++;
+        if (onShot && !onShot(res))
+            break;
+    }
+    return shots;
+}
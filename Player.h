@@ -2,10 +2,15 @@
 #define PLAYER_INCLUDED
 
 #include <string>
+#include <iosfwd>
+#include <functional>
 
 class Point;
 class Board;
 class Game;
+struct AttackResult;
+struct OpponentPrior;
+struct GoodParams;
 
 class Player
 {
@@ -23,9 +28,30 @@ class Player
 
     virtual bool placeShips(Board& b) = 0;
     virtual Point recommendAttack() = 0;
+      // Salvo: fill up to k cells to fire at this turn, best first,
+      // with a score for each; returns how many were filled
+    virtual int recommendAttacks(Point* shots, int* scores, int k);
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
                                         bool shipDestroyed, int shipId) = 0;
     virtual void recordAttackByOpponent(Point p) = 0;
+      // Strategy-specific metrics, if any
+    virtual void reportStats(std::ostream& out) const {}
+      // Analysis: for strategies that score cells, fills density (indexed
+      // like a Bitboard) with the score of every cell and best with the
+      // cell recommendAttack would pick, and returns true
+    virtual bool densityMap(int* density, Point& best) { return false; }
+      // Calibration: the strategy's own probability, from 0 to 1, that
+      // the shot recommendAttack last returned hits, or -1 if it has none
+    virtual double hitProbability() const { return -1; }
+      // Learning: what is known (see OpponentModel.h) of where this
+      // game's opponent puts its ships and fires its first shots, or
+      // nullptr; given before placeShips, and must outlive the game
+    virtual void useOpponentPrior(const OpponentPrior* prior) {}
+      // Checkpointing: the strategy's state between moves as
+      // whitespace-separated tokens on one line, and restoring it
+      // into a newly created player of the same type
+    virtual void saveState(std::ostream& out) const {}
+    virtual bool loadState(std::istream& in) { return true; }
       // We prevent any kind of Player object from being copied or assigned
     Player(const Player&) = delete;
     Player& operator=(const Player&) = delete;
@@ -37,4 +63,37 @@ class Player
 
 Player* createPlayer(std::string type, std::string nm, const Game& g);
 
+  // A "good" player built with other constants than TUNED_GOOD_PARAMS,
+  // for tuning them (see GoodParams.h)
+Player* createGoodPlayer(std::string nm, const Game& g, const GoodParams& params);
+
+  // Has p attack the fleet on b until it is sunk or p has fired 4 shots
+  // per cell, and returns the shots fired; the fleet may still stand.
+  // chooseUs, if given, is added the microseconds p spent choosing
+  // shots. onShot, if given, hears each shot after p has, and returning
+  // false from it ends the attack there.
+int attackUntilSunk(Player& p, Board& b, double* chooseUs = nullptr,
+                    const std::function<bool(const AttackResult&)>& onShot = nullptr);
+
+  // Limits on placeSturdyFleet's search
+struct RolloutBudget
+{
+    int candidates;  // random fleets drawn
+    double ms;       // wall time for all rollouts together
+    int nThreads;    // threads to roll out on, counting the caller's
+};
+
+  // What a "sturdy" player spends on placing ships: a rollout takes
+  // about 0.7 ms on 10x10, so about 7 ms a game; one thread, since
+  // tournaments already keep every thread busy
+const RolloutBudget DEFAULT_ROLLOUT_BUDGET = { 8, 8, 1 };
+
+  // Simulation-scored placement: draws budget.candidates random fleets,
+  // has a fresh GoodPlayer hunt each one down, and places the one it
+  // needed the most shots for. Rollouts unfinished when budget.ms has
+  // passed count for nothing, so placement takes little more than
+  // budget.ms however large the board or candidates.
+  // Returns false, with b as it was, if no fleet could be placed.
+bool placeSturdyFleet(Board& b, const Game& g, const RolloutBudget& budget);
+
 #endif // PLAYER_INCLUDED
@@ -0,0 +1,161 @@
+"""ctypes bridge to the C++ engine (libbattleship.so).
+
+Build the library from the repository root:
+    g++ -std=c++17 -O2 -fPIC -shared -fvisibility=hidden -pthread -DNO_HEAP_ACCOUNTING \
+        Battleship.cpp Accounting.cpp Board.cpp Capture.cpp Game.cpp GameRecord.cpp Histogram.cpp \
+        OpponentModel.cpp Player.cpp ResultStore.cpp Shard.cpp Sprt.cpp Tournament.cpp Trace.cpp utility.cpp \
+        -o libbattleship.so
+
+The library is looked up in $BATTLESHIP_LIB, then the repository root.
+
+    game = Game(10, 10)          # standard fleet
+    pos = Position(game, "good")
+    pos.place_layout(layout)     # rows of '.' and ship symbols
+    pos.shoot(4, 4)
+    heat = pos.density()         # (rows, cols) int32 array, filled by C++ in place
+"""
+
+import ctypes
+import os
+from ctypes import POINTER, c_char, c_char_p, c_int, c_int32, c_uint, c_void_p
+
+import numpy as np
+
+ABI_VERSION = 1
+
+
+def _load():
+    path = os.environ.get("BATTLESHIP_LIB")
+    if not path:
+        root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+        path = os.path.join(root, "libbattleship.so")
+    lib = ctypes.CDLL(path)
+
+    def fn(name, restype, *argtypes):
+        f = getattr(lib, name)
+        f.restype = restype
+        f.argtypes = list(argtypes)
+
+    fn("bs_abi_version", c_int)
+    fn("bs_last_error", c_char_p)
+    fn("bs_seed", None, c_uint)
+    fn("bs_game_new", c_void_p, c_int, c_int)
+    fn("bs_game_free", None, c_void_p)
+    fn("bs_game_add_ship", c_int, c_void_p, c_int, c_char, c_char_p)
+    fn("bs_game_add_standard_ships", c_int, c_void_p)
+    fn("bs_game_rows", c_int, c_void_p)
+    fn("bs_game_cols", c_int, c_void_p)
+    fn("bs_game_ships", c_int, c_void_p)
+    fn("bs_position_new", c_void_p, c_void_p, c_char_p)
+    fn("bs_position_free", None, c_void_p)
+    fn("bs_position_place", c_int, c_void_p, c_int, c_int, c_int, c_int)
+    fn("bs_position_place_layout", c_int, c_void_p, c_char_p)
+    fn("bs_position_shoot", c_int, c_void_p, c_int, c_int, POINTER(c_int), POINTER(c_int), POINTER(c_int))
+    fn("bs_position_record", c_int, c_void_p, c_int, c_int, c_int, c_int, c_int, c_int)
+    fn("bs_position_density", c_int, c_void_p, POINTER(c_int32), c_int, c_int, POINTER(c_int), POINTER(c_int))
+    fn("bs_position_recommend", c_int, c_void_p, POINTER(c_int), POINTER(c_int))
+    fn("bs_position_ships_afloat", c_int, c_void_p)
+
+    if lib.bs_abi_version() != ABI_VERSION:
+        raise ImportError("%s has ABI version %d, expected %d" % (path, lib.bs_abi_version(), ABI_VERSION))
+    return lib
+
+
+_lib = _load()
+
+
+class BattleshipError(RuntimeError):
+    pass
+
+
+def _check(status):
+    if status < 0:
+        raise BattleshipError(_lib.bs_last_error().decode())
+    return status
+
+
+def seed(value):
+    """Seeds the engine's random numbers (shared by every position)."""
+    _lib.bs_seed(value)
+
+
+class Game:
+    """Board size and fleet. ships is a list of (length, symbol, name);
+    None gives the standard fleet. Positions keep their game alive."""
+
+    def __init__(self, rows=10, cols=10, ships=None):
+        self._handle = _lib.bs_game_new(rows, cols)
+        if not self._handle:
+            raise BattleshipError(_lib.bs_last_error().decode())
+        if ships is None:
+            _check(_lib.bs_game_add_standard_ships(self._handle))
+        else:
+            for length, symbol, name in ships:
+                _check(_lib.bs_game_add_ship(self._handle, length, symbol.encode(), name.encode()))
+        self.rows = _lib.bs_game_rows(self._handle)
+        self.cols = _lib.bs_game_cols(self._handle)
+        self.ships = _lib.bs_game_ships(self._handle)
+
+    def __del__(self):
+        if getattr(self, "_handle", None):
+            _lib.bs_game_free(self._handle)
+            self._handle = None
+
+
+class Position:
+    """One board's ships and one strategy's view of the shots at it."""
+
+    def __init__(self, game, strategy="good"):
+        self.game = game
+        self._handle = _lib.bs_position_new(game._handle, strategy.encode())
+        if not self._handle:
+            raise BattleshipError(_lib.bs_last_error().decode())
+
+    def __del__(self):
+        if getattr(self, "_handle", None):
+            _lib.bs_position_free(self._handle)
+            self._handle = None
+
+    def place(self, ship_id, row, col, vertical=False):
+        _check(_lib.bs_position_place(self._handle, ship_id, row, col, int(vertical)))
+
+    def place_layout(self, layout):
+        """layout is a string of rows, or a list of row strings."""
+        if not isinstance(layout, str):
+            layout = "\n".join(layout)
+        _check(_lib.bs_position_place_layout(self._handle, layout.encode()))
+
+    def shoot(self, row, col):
+        """Fires at the placed ships and tells the strategy.
+        Returns (valid, hit, destroyed, ship_id)."""
+        hit, destroyed, ship_id = c_int(), c_int(), c_int()
+        valid = _check(_lib.bs_position_shoot(self._handle, row, col, ctypes.byref(hit),
+                                              ctypes.byref(destroyed), ctypes.byref(ship_id)))
+        return bool(valid), bool(hit.value), bool(destroyed.value), ship_id.value
+
+    def record(self, row, col, hit, destroyed=False, ship_id=-1, valid=True):
+        """Tells the strategy the result of a shot fired elsewhere."""
+        _check(_lib.bs_position_record(self._handle, row, col, int(valid), int(hit), int(destroyed), ship_id))
+
+    def density(self, out=None):
+        """Returns the strategy's density map as a (rows, cols) int32 array.
+        If out is given (C-contiguous int32 of that shape) it is filled in
+        place and returned, so repeated calls allocate nothing."""
+        shape = (self.game.rows, self.game.cols)
+        if out is None:
+            out = np.empty(shape, dtype=np.int32)
+        elif out.shape != shape or out.dtype != np.int32 or not out.flags.c_contiguous:
+            raise ValueError("out must be a C-contiguous int32 array of shape %s" % (shape,))
+        best_row, best_col = c_int(), c_int()
+        _check(_lib.bs_position_density(self._handle, out.ctypes.data_as(POINTER(c_int32)), shape[0], shape[1],
+                                        ctypes.byref(best_row), ctypes.byref(best_col)))
+        self.best = (best_row.value, best_col.value)
+        return out
+
+    def recommend(self):
+        row, col = c_int(), c_int()
+        _check(_lib.bs_position_recommend(self._handle, ctypes.byref(row), ctypes.byref(col)))
+        return row.value, col.value
+
+    def ships_afloat(self):
+        return _check(_lib.bs_position_ships_afloat(self._handle))
@@ -0,0 +1,388 @@
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -pthread Query/query.cpp Accounting.cpp Board.cpp Capture.cpp Game.cpp GameRecord.cpp Histogram.cpp OpponentModel.cpp Player.cpp ResultStore.cpp Shard.cpp Sprt.cpp Tournament.cpp Trace.cpp utility.cpp
+//
+// Usage:
+//   query results.bsrc [--where cond]... [--group col]... [--avg col] [--sum col]
+//                      [--min col] [--max col] [--threads n]
+//   query --import games.bsgr results.bsrc
+//
+// Filtered aggregation over a columnar result file, one row per player
+// per game. A condition is col=value, col!=value, col<value, col<=value,
+// col>value, col>=value or col&mask (any mask bit set); strategy and
+// opponent compare by name. Row groups are scanned on all threads, and
+// only the columns a query uses are decoded.
+//
+// Columns: game seed rows cols strategy opponent first won shots
+//          ownvert oppvert ownedge oppedge us calls maxus cpuus peakbytes
+//
+// Average shots to win for good against mediocre on 10x10 when the
+// opponent's carrier (ship 0) is vertical:
+//   query results.bsrc --where strategy=good --where opponent=mediocre
+//         --where rows=10 --where cols=10 --where won=1 --where oppvert&1 --avg shots
+//
+// --import converts a game-record file; timing columns are then 0.
+
+#include "../Game.h"
+#include "../GameRecord.h"
+#include "../ResultStore.h"
+#include "../utility.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <cstdlib>
+#include <cstdint>
+
+using namespace std;
+
+enum CompareOp {
+    EQ, NE, LT, LE, GT, GE, ANY_BITS
+};
+
+struct Condition
+{
+    int column;
+    CompareOp op;
+    int64_t value;
+    string name;      // value of a dictionary column
+};
+
+enum AggregateOp {
+    AVG, SUM, MIN, MAX
+};
+
+struct Aggregate
+{
+    AggregateOp op;
+    int column;
+};
+
+struct Accumulator
+{
+    long long count = 0;
+    vector<double> sums;
+    vector<int64_t> mins;
+    vector<int64_t> maxs;
+
+    void add(const vector<Aggregate>& aggs, const vector<int64_t>* cols, int row)
+    {
+        if (count == 0)
+        {
+            sums.assign(aggs.size(), 0);
+            mins.assign(aggs.size(), INT64_MAX);
+            maxs.assign(aggs.size(), INT64_MIN);
+        }
+        count++;
+        for (size_t a = 0; a < aggs.size(); a++)
+        {
+            int64_t v = cols[aggs[a].column][row];
+            sums[a] += v;
+            if (v < mins[a])
+                mins[a] = v;
+            if (v > maxs[a])
+                maxs[a] = v;
+        }
+    }
+
+    void merge(const Accumulator& other)
+    {
+        if (other.count == 0)
+            return;
+        if (count == 0)
+        {
+            *this = other;
+            return;
+        }
+        count += other.count;
+        for (size_t a = 0; a < sums.size(); a++)
+        {
+            sums[a] += other.sums[a];
+            mins[a] = min(mins[a], other.mins[a]);
+            maxs[a] = max(maxs[a], other.maxs[a]);
+        }
+    }
+};
+
+bool isDictColumn(int column)
+{
+    return column == COL_STRATEGY || column == COL_OPPONENT;
+}
+
+//######################
+// Parses col OP value, or returns false
+//######################
+bool parseCondition(const string& text, Condition& cond)
+{
+    static const pair<const char*, CompareOp> ops[] = {
+        { "!=", NE }, { "<=", LE }, { ">=", GE }, { "=", EQ }, { "<", LT }, { ">", GT }, { "&", ANY_BITS }
+    };
+    for (const auto& op : ops)
+    {
+        size_t at = text.find(op.first);
+        if (at == string::npos || at == 0)
+            continue;
+        cond.column = resultColumn(text.substr(0, at));
+        cond.op = op.second;
+        string value = text.substr(at + string(op.first).size());
+        if (cond.column < 0 || value.empty())
+            return false;
+        if (isDictColumn(cond.column))
+        {
+            cond.name = value;
+            return cond.op == EQ || cond.op == NE;
+        }
+        cond.value = strtoll(value.c_str(), nullptr, 0);
+        return true;
+    }
+    return false;
+}
+
+bool passes(const Condition& cond, int64_t v)
+{
+    switch (cond.op)
+    {
+      case EQ:       return v == cond.value;
+      case NE:       return v != cond.value;
+      case LT:       return v < cond.value;
+      case LE:       return v <= cond.value;
+      case GT:       return v > cond.value;
+      case GE:       return v >= cond.value;
+      case ANY_BITS: return (v & cond.value) != 0;
+    }
+    return false;
+}
+
+//######################
+// Converts a game-record file into a result file
+//######################
+int importRecords(const string& from, const string& to)
+{
+    MappedRecords records;
+    ResultWriter writer;
+    if (!records.open(from) || !writer.open(to))
+    {
+        cerr << "Cannot import " << from << " into " << to << endl;
+        return 1;
+    }
+    GameRecord rec;
+    PlayerClock clocks[2] = {};
+    for (size_t n = 0; n < records.size(); n++)
+    {
+        if (!records.get(n, rec))
+            continue;
+        // Tournament players are named type + side number
+        string types[2];
+        for (int who = 0; who < 2; who++)
+        {
+            size_t end = rec.names[who].find_last_not_of("0123456789");
+            types[who] = rec.names[who].substr(0, end == string::npos ? 0 : end + 1);
+        }
+        writer.addGame(rec, static_cast<long long>(n), types, clocks);
+    }
+    writer.close();
+    cout << "Imported " << records.size() << " games" << endl;
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc == 4 && string(argv[1]) == "--import")
+        return importRecords(argv[2], argv[3]);
+    if (argc < 2)
+    {
+        cerr << "Usage: query results.bsrc [--where cond]... [--group col]... [--avg|--sum|--min|--max col]... [--threads n]" << endl;
+        return 2;
+    }
+
+    vector<Condition> conds;
+    vector<int> groupBy;
+    vector<Aggregate> aggs;
+    int nThreads = thread::hardware_concurrency();
+    for (int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        string value = i + 1 < argc ? argv[i + 1] : "";
+        i++;
+        if (arg == "--where")
+        {
+            Condition cond;
+            if (!parseCondition(value, cond))
+            {
+                cerr << "Bad condition " << value << endl;
+                return 2;
+            }
+            conds.push_back(cond);
+        }
+        else if (arg == "--threads")
+            nThreads = atoi(value.c_str());
+        else if (arg == "--group" || arg == "--avg" || arg == "--sum" || arg == "--min" || arg == "--max")
+        {
+            int column = resultColumn(value);
+            if (column < 0)
+            {
+                cerr << "Unknown column " << value << endl;
+                return 2;
+            }
+            if (arg == "--group")
+                groupBy.push_back(column);
+            else
+                aggs.push_back(Aggregate{ arg == "--avg" ? AVG : arg == "--sum" ? SUM : arg == "--min" ? MIN : MAX, column });
+        }
+        else
+        {
+            cerr << "Unknown argument " << arg << endl;
+            return 2;
+        }
+    }
+    if (nThreads < 1)
+        nThreads = 1;
+
+    ResultFile file;
+    if (!file.open(argv[1]))
+    {
+        cerr << "Cannot read results from " << argv[1] << endl;
+        return 1;
+    }
+
+    // One dictionary across groups, so grouped names line up
+    vector<string> names;
+    vector<vector<int64_t>> toGlobal(file.nGroups());
+    for (size_t g = 0; g < file.nGroups(); g++)
+        for (const string& name : file.groupDict(g))
+        {
+            size_t id = 0;
+            while (id < names.size() && names[id] != name)
+                id++;
+            if (id == names.size())
+                names.push_back(name);
+            toGlobal[g].push_back(id);
+        }
+
+    bool used[NRESULTCOLUMNS] = {};
+    for (const Condition& c : conds)
+        used[c.column] = true;
+    for (int c : groupBy)
+        used[c] = true;
+    for (const Aggregate& a : aggs)
+        used[a.column] = true;
+
+    map<vector<int64_t>, Accumulator> total;
+    mutex mergeLock;
+    atomic<size_t> nextGroup(0);
+    atomic<long long> nScanned(0);
+    auto worker = [&]()
+    {
+        vector<int64_t> cols[NRESULTCOLUMNS];
+        map<vector<int64_t>, Accumulator> local;
+        Accumulator single;
+        vector<int64_t> key(groupBy.size());
+        vector<Condition> groupConds;
+
+        for (size_t g = nextGroup++; g < file.nGroups(); g = nextGroup++)
+        {
+            // Name conditions become id conditions for this group
+            groupConds = conds;
+            bool possible = true;
+            for (Condition& c : groupConds)
+                if (isDictColumn(c.column))
+                {
+                    const vector<string>& dict = file.groupDict(g);
+                    c.value = -1;
+                    for (size_t id = 0; id < dict.size(); id++)
+                        if (dict[id] == c.name)
+                            c.value = id;
+                    if (c.value < 0 && c.op == EQ)
+                        possible = false;
+                }
+            int nRows = file.groupRows(g);
+            nScanned += nRows;
+            if (!possible)
+                continue;
+
+            for (int c = 0; c < NRESULTCOLUMNS; c++)
+                if (used[c])
+                    file.decode(g, c, cols[c]);
+
+            for (int row = 0; row < nRows; row++)
+            {
+                bool match = true;
+                for (const Condition& c : groupConds)
+                    if (!passes(c, cols[c.column][row]))
+                    {
+                        match = false;
+                        break;
+                    }
+                if (!match)
+                    continue;
+                if (groupBy.empty())
+                {
+                    single.add(aggs, cols, row);
+                    continue;
+                }
+                for (size_t k = 0; k < groupBy.size(); k++)
+                {
+                    int64_t v = cols[groupBy[k]][row];
+                    key[k] = isDictColumn(groupBy[k]) && v >= 0 && v < static_cast<int64_t>(toGlobal[g].size())
+                           ? toGlobal[g][v] : v;
+                }
+                local[key].add(aggs, cols, row);
+            }
+        }
+
+        lock_guard<mutex> lock(mergeLock);
+        if (groupBy.empty())
+            total[key].merge(single);
+        for (const auto& entry : local)
+            total[entry.first].merge(entry.second);
+    };
+
+    Timer timer;
+    vector<thread> threads;
+    for (int t = 0; t < nThreads; t++)
+        threads.push_back(thread(worker));
+    for (thread& t : threads)
+        t.join();
+    double ms = timer.elapsed();
+
+    static const char* aggNames[] = { "avg", "sum", "min", "max" };
+    for (int c : groupBy)
+        cout << RESULT_COLUMN_NAMES[c] << '\t';
+    cout << "count";
+    for (const Aggregate& a : aggs)
+        cout << '\t' << aggNames[a.op] << "(" << RESULT_COLUMN_NAMES[a.column] << ")";
+    cout << endl;
+
+    for (const auto& entry : total)
+    {
+        const Accumulator& acc = entry.second;
+        for (size_t k = 0; k < groupBy.size(); k++)
+        {
+            int64_t v = entry.first[k];
+            if (isDictColumn(groupBy[k]) && v >= 0 && v < static_cast<int64_t>(names.size()))
+                cout << names[v] << '\t';
+            else
+                cout << v << '\t';
+        }
+        cout << acc.count;
+        for (size_t a = 0; a < aggs.size(); a++)
+        {
+            cout << '\t';
+            if (acc.count == 0)
+                continue;
+            switch (aggs[a].op)
+            {
+              case AVG: cout << fixed << setprecision(3) << acc.sums[a] / acc.count; break;
+              case SUM: cout << fixed << setprecision(0) << acc.sums[a]; break;
+              case MIN: cout << acc.mins[a]; break;
+              case MAX: cout << acc.maxs[a]; break;
+            }
+        }
+        cout << endl;
+    }
+    cerr << nScanned << " rows in " << fixed << setprecision(1) << ms << " ms" << endl;
+    return 0;
+}
@@ -0,0 +1,249 @@
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -pthread Replay/replay.cpp Accounting.cpp Board.cpp Capture.cpp Game.cpp GameRecord.cpp Histogram.cpp OpponentModel.cpp Player.cpp ResultStore.cpp Shard.cpp Sprt.cpp Tournament.cpp Trace.cpp utility.cpp
+//
+// Usage:
+//   replay records.bsgr strategy [--player prefix] [--threads n] [--limit n] [--out deltas.tsv]
+//
+// Re-fights recorded games with a new strategy. For every game that was
+// decided by a sinking (games lost on time are skipped), each recorded
+// player's strategy (its name less any trailing digits; only players
+// whose names start with prefix, if given) and the new strategy both
+// attack the opponent's placement, seeded alike from the record, and
+// their shot counts are compared. Both boards of a game are replayed,
+// so boards the recorded player lost on count as much as those it won.
+// Players that aren't a known strategy and salvo games are skipped.
+//
+// Prints a summary; --out writes one tab-separated line per game.
+
+#include "../Game.h"
+#include "../Player.h"
+#include "../Board.h"
+#include "../globals.h"
+#include "../GameRecord.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+struct Replayed
+{
+    int side;      // recorded player whose strategy is compared, or -1 if skipped
+    int oldShots;  // -1 if the board could not be rebuilt
+    int newShots;
+};
+
+//######################
+// Shots the strategy needs to sink one side's fleet
+//
+// Returns -1 if the board or player can't be built, or
+// the strategy has not won after 4 shots per cell
+//######################
+int replayBoard(const GameRecord& rec, int target, const string& type)
+{
+    Game g(rec.rows, rec.cols);
+    g.setVerbose(false);
+    for (const ShipType& st : rec.ships)
+        if (!g.addShip(st.length, st.symbol, st.name))
+            return -1;
+
+    Board b(g);
+    for (int shipId = 0; shipId < g.nShips(); shipId++)
+    {
+        const GameRecord::Placement& pl = rec.placements[target][shipId];
+        if (!b.placeShip(pl.topOrLeft, shipId, pl.dir))
+            return -1;
+    }
+
+    Player* p = createPlayer(type, type, g);
+    if (p == nullptr)
+        return -1;
+
+    // Same random numbers for every replay of this board
+    seedRandom(rec.seed * 2 + target);
+    int shots = attackUntilSunk(*p, b);
+    delete p;
+    return b.allShipsDestroyed() ? shots : -1;
+}
+
+//######################
+// Strategy a recorded player used: its name without
+// the side number tournaments append, or "" if that
+// is not a strategy that can be replayed
+//######################
+string recordedType(const string& name)
+{
+    size_t end = name.find_last_not_of("0123456789");
+    string type = name.substr(0, end == string::npos ? 0 : end + 1);
+    if (type == "human")
+        return "";
+
+    // Records hold few names, so each is tried once per thread
+    thread_local map<string, bool> known;
+    auto it = known.find(type);
+    if (it == known.end())
+    {
+        Game g(10, 10);
+        Player* p = createPlayer(type, type, g);
+        it = known.emplace(type, p != nullptr).first;
+        delete p;
+    }
+    return it->second ? type : "";
+}
+
+//######################
+// Checks if the winner sank the loser's whole fleet,
+// rather than winning because the loser ran out of time
+//######################
+bool wonBySinking(const GameRecord& rec)
+{
+    int nSunk = 0;
+    for (const GameRecord::Shot& shot : rec.shots)
+        if (shot.who == rec.winner && shot.valid && shot.shipDestroyed)
+            nSunk++;
+    return nSunk == static_cast<int>(rec.ships.size());
+}
+
+//######################
+// Replays the board side attacked in one record with
+// side's recorded strategy and with type, if it qualifies
+//######################
+Replayed replayRecord(const GameRecord& rec, int side, const string& type, const string& prefix)
+{
+    Replayed r = { -1, 0, 0 };
+    if (rec.winner < 0 || rec.shotsPerTurn != 1 || !wonBySinking(rec) ||
+        rec.names[side].compare(0, prefix.size(), prefix) != 0)
+        return r;
+    string oldType = recordedType(rec.names[side]);
+    if (oldType.empty())
+        return r;
+
+    r.side = side;
+    r.oldShots = replayBoard(rec, 1 - side, oldType);
+    r.newShots = replayBoard(rec, 1 - side, type);
+    return r;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        cerr << "Usage: replay records.bsgr strategy [--player prefix] [--threads n] [--limit n] [--out deltas.tsv]" << endl;
+        return 2;
+    }
+    string path = argv[1];
+    string type = argv[2];
+    string prefix;
+    string outPath;
+    int nThreads = thread::hardware_concurrency();
+    size_t limit = 0;
+
+    for (int i = 3; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--player" && i + 1 < argc)
+            prefix = argv[++i];
+        else if (arg == "--threads" && i + 1 < argc)
+            nThreads = atoi(argv[++i]);
+        else if (arg == "--limit" && i + 1 < argc)
+            limit = atol(argv[++i]);
+        else if (arg == "--out" && i + 1 < argc)
+            outPath = argv[++i];
+        else
+        {
+            cerr << "Unknown argument " << arg << endl;
+            return 2;
+        }
+    }
+    if (type == "human")
+    {
+        cerr << "Can't replay against a human player" << endl;
+        return 2;
+    }
+    if (nThreads < 1)
+        nThreads = 1;
+
+    MappedRecords records;
+    if (!records.open(path))
+    {
+        cerr << "Cannot read game records from " << path << endl;
+        return 1;
+    }
+    size_t nRecords = limit > 0 && limit < records.size() ? limit : records.size();
+
+    // Each board's result goes in its own slot, so threads never share one
+    vector<Replayed> results(2 * nRecords);
+    atomic<size_t> next(0);
+    auto worker = [&]()
+    {
+        GameRecord rec;
+        for (size_t n = next++; n < nRecords; n = next++)
+        {
+            bool read = records.get(n, rec);
+            for (int side = 0; side < 2; side++)
+                results[2 * n + side] = read ? replayRecord(rec, side, type, prefix) : Replayed{ -1, 0, 0 };
+        }
+    };
+    vector<thread> threads;
+    for (int t = 0; t < nThreads; t++)
+        threads.push_back(thread(worker));
+    for (thread& t : threads)
+        t.join();
+
+    ofstream out;
+    if (!outPath.empty())
+    {
+        out.open(outPath);
+        out << "record\tside\told\tnew\tdelta" << endl;
+    }
+
+    long long nCompared = 0, nFailed = 0, nBetter = 0, nWorse = 0;
+    double sumOld = 0, sumNew = 0, sumDelta = 0, sumDelta2 = 0;
+    for (size_t n = 0; n < 2 * nRecords; n++)
+    {
+        const Replayed& r = results[n];
+        if (r.side < 0)
+            continue;
+        if (r.oldShots < 0 || r.newShots < 0)
+        {
+            nFailed++;
+            continue;
+        }
+        int delta = r.newShots - r.oldShots;
+        nCompared++;
+        sumOld += r.oldShots;
+        sumNew += r.newShots;
+        sumDelta += delta;
+        sumDelta2 += double(delta) * delta;
+        if (delta < 0)
+            nBetter++;
+        else if (delta > 0)
+            nWorse++;
+        if (out.is_open())
+            out << n / 2 << '\t' << r.side << '\t' << r.oldShots << '\t' << r.newShots << '\t' << delta << '\n';
+    }
+
+    cout << nRecords << " records, " << nCompared << " boards replayed with " << type;
+    if (nFailed > 0)
+        cout << " (" << nFailed << " failed)";
+    cout << endl;
+    if (nCompared == 0)
+        return 0;
+
+    double meanDelta = sumDelta / nCompared;
+    double var = nCompared > 1 ? (sumDelta2 - nCompared * meanDelta * meanDelta) / (nCompared - 1) : 0;
+    cout << fixed << setprecision(2)
+         << "  shots to sink: recorded strategies " << sumOld / nCompared << ", " << type << " " << sumNew / nCompared << endl
+         << "  delta " << showpos << meanDelta << noshowpos << " +/- " << sqrt(var / nCompared)
+         << " (s.e.), sd " << sqrt(var) << endl
+         << "  fewer shots on " << nBetter << ", more on " << nWorse << ", same on "
+         << nCompared - nBetter - nWorse << endl;
+    return 0;
+}
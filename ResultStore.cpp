@@ -0,0 +1,352 @@
+#include "ResultStore.h"
+#include "GameRecord.h"
+#include "Game.h"
+#include <cstring>
+
+using namespace std;
+
+const char* const RESULT_COLUMN_NAMES[NRESULTCOLUMNS] = {
+    "game", "seed", "rows", "cols", "strategy", "opponent",
+    "first", "won", "shots", "ownvert", "oppvert", "ownedge", "oppedge",
+    "us", "calls", "maxus", "cpuus", "peakbytes"
+};
+
+namespace
+{
+    const char MAGIC[4] = { 'B', 'S', 'R', 'C' };
+    const int FILE_HEADER = 8;
+
+    void putVarint(string& out, uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<char>(v));
+    }
+
+    // Small negative deltas stay small: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+    uint64_t zigzag(int64_t v)
+    {
+        return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+    }
+
+    int64_t unzigzag(uint64_t v)
+    {
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+
+    // Ships of one side that are vertical (as a mask) and touch an edge
+    void placementFeatures(const GameRecord& rec, int who, int64_t& vertical, int64_t& edge)
+    {
+        vertical = 0;
+        edge = 0;
+        for (size_t shipId = 0; shipId < rec.placements[who].size() && shipId < rec.ships.size(); shipId++)
+        {
+            const GameRecord::Placement& pl = rec.placements[who][shipId];
+            int len = rec.ships[shipId].length;
+            Point end = pl.dir == VERTICAL ? Point(pl.topOrLeft.r + len - 1, pl.topOrLeft.c)
+                                           : Point(pl.topOrLeft.r, pl.topOrLeft.c + len - 1);
+            if (pl.dir == VERTICAL && shipId < 63)
+                vertical |= int64_t(1) << shipId;
+            if (pl.topOrLeft.r == 0 || pl.topOrLeft.c == 0 || end.r == rec.rows - 1 || end.c == rec.cols - 1)
+                edge++;
+        }
+    }
+}
+
+int resultColumn(const string& name)
+{
+    for (int c = 0; c < NRESULTCOLUMNS; c++)
+        if (name == RESULT_COLUMN_NAMES[c])
+            return c;
+    return -1;
+}
+
+//******************** ResultWriter functions *************************
+
+ResultWriter::ResultWriter() : m_open(false), m_closing(false) {}
+
+ResultWriter::~ResultWriter()
+{
+    close();
+}
+
+//####################
+// Opens a result file for appending, writing the
+// header if it is new
+// Returns false if it can't be written or is not a
+// result file of this version
+//####################
+bool ResultWriter::open(const string& path)
+{
+    if (m_open)
+        return false;
+
+    char header[FILE_HEADER] = {};
+    ifstream existing(path, ios::binary);
+    existing.read(header, FILE_HEADER);
+    bool isNew = existing.gcount() == 0;
+    if (!isNew && (existing.gcount() < FILE_HEADER || memcmp(header, MAGIC, 4) != 0 || header[4] != RESULT_VERSION))
+        return false;
+    existing.close();
+
+    m_file.open(path, ios::binary | ios::app);
+    if (!m_file)
+        return false;
+    if (isNew)
+    {
+        memcpy(header, MAGIC, 4);
+        header[4] = RESULT_VERSION;
+        m_file.write(header, FILE_HEADER);
+    }
+    m_open = true;
+    m_closing = false;
+    m_group = Group();
+    m_thread = thread(&ResultWriter::writerLoop, this);
+    return true;
+}
+
+int ResultWriter::intern(const string& name)
+{
+    vector<string>& dict = m_group.dict;
+    for (size_t n = 0; n < dict.size(); n++)
+        if (dict[n] == name)
+            return static_cast<int>(n);
+    dict.push_back(name);
+    return static_cast<int>(dict.size()) - 1;
+}
+
+//####################
+// Adds one row for each player of a finished game
+//####################
+void ResultWriter::addGame(const GameRecord& rec, long long game,
+                           const string types[2], const PlayerClock clocks[2])
+{
+    int64_t shots[2] = { 0, 0 };
+    for (const GameRecord::Shot& shot : rec.shots)
+        shots[shot.who]++;
+    int64_t vertical[2], edge[2];
+    for (int who = 0; who < 2; who++)
+        placementFeatures(rec, who, vertical[who], edge[who]);
+
+    lock_guard<mutex> lock(m_lock);
+    if (!m_open)
+        return;
+    for (int who = 0; who < 2; who++)
+    {
+        int64_t row[NRESULTCOLUMNS] = {
+            game, rec.seed, rec.rows, rec.cols, intern(types[who]), intern(types[1 - who]),
+            who == 0, rec.winner == who, shots[who],
+            vertical[who], vertical[1 - who], edge[who], edge[1 - who],
+            static_cast<int64_t>(clocks[who].usedMs * 1000), clocks[who].calls,
+            static_cast<int64_t>(clocks[who].maxCallMs * 1000),
+            static_cast<int64_t>(clocks[who].cpuMs * 1000), clocks[who].heap.peakBytes
+        };
+        for (int c = 0; c < NRESULTCOLUMNS; c++)
+            m_group.columns[c].push_back(row[c]);
+        m_group.nRows++;
+    }
+    if (m_group.nRows >= ROWS_PER_GROUP)
+    {
+        m_full.push_back(move(m_group));
+        m_group = Group();
+        m_wake.notify_one();
+    }
+}
+
+//####################
+// Encodes and writes one group
+//####################
+void ResultWriter::writeGroup(const Group& group)
+{
+    if (group.nRows == 0)
+        return;
+
+    string columnData[NRESULTCOLUMNS];
+    for (int c = 0; c < NRESULTCOLUMNS; c++)
+    {
+        int64_t prev = 0;
+        for (int64_t v : group.columns[c])
+        {
+            putVarint(columnData[c], zigzag(v - prev));
+            prev = v;
+        }
+    }
+
+    string bytes;
+    putU32(bytes, 0);
+    putU32(bytes, group.nRows);
+    putU8(bytes, static_cast<int>(group.dict.size()));
+    for (const string& name : group.dict)
+        putName(bytes, name);
+    putU8(bytes, NRESULTCOLUMNS);
+    for (int c = 0; c < NRESULTCOLUMNS; c++)
+    {
+        putName(bytes, RESULT_COLUMN_NAMES[c]);
+        putU32(bytes, static_cast<uint32_t>(columnData[c].size()));
+    }
+    for (int c = 0; c < NRESULTCOLUMNS; c++)
+        bytes += columnData[c];
+
+    uint32_t length = static_cast<uint32_t>(bytes.size() - 4);
+    for (int i = 0; i < 4; i++)
+        bytes[i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+    m_file.write(bytes.data(), bytes.size());
+}
+
+void ResultWriter::writerLoop()
+{
+    unique_lock<mutex> lock(m_lock);
+    while (true)
+    {
+        m_wake.wait(lock, [this] { return !m_full.empty() || m_closing; });
+        if (m_full.empty())
+            return;
+
+        // Producers only push at the back, so the front stays put
+        lock.unlock();
+        writeGroup(m_full.front());
+        lock.lock();
+        m_full.pop_front();
+    }
+}
+
+//####################
+// Writes every row added and closes the file
+//####################
+void ResultWriter::close()
+{
+    {
+        lock_guard<mutex> lock(m_lock);
+        if (!m_open)
+            return;
+        m_closing = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+
+    lock_guard<mutex> lock(m_lock);
+    writeGroup(m_group);
+    m_group = Group();
+    m_file.close();
+    m_open = false;
+}
+
+//******************** ResultFile functions ***************************
+
+//####################
+// Maps a result file and indexes its groups
+// A truncated or malformed last group is ignored
+//####################
+bool ResultFile::open(const string& path)
+{
+    m_groups.clear();
+    if (!m_file.open(path))
+        return false;
+    const unsigned char* base = reinterpret_cast<const unsigned char*>(m_file.data());
+    size_t size = m_file.size();
+    if (size < FILE_HEADER || memcmp(base, MAGIC, 4) != 0 || base[4] != RESULT_VERSION)
+    {
+        m_file.close();
+        return false;
+    }
+
+    for (size_t pos = FILE_HEADER; pos + 4 <= size; )
+    {
+        size_t length = getU32(base + pos);
+        const unsigned char* p = base + pos + 4;
+        const unsigned char* end = p + length;
+        if (pos + 4 + length > size || length < 6)
+            break;
+        pos += 4 + length;
+
+        Group g;
+        g.nRows = getU32(p);
+        p += 4;
+        for (int c = 0; c < NRESULTCOLUMNS; c++)
+        {
+            g.data[c] = nullptr;
+            g.size[c] = 0;
+        }
+
+        // Dictionary, then the column directory
+        bool ok = true;
+        auto name = [&]() {
+            if (p >= end || end - p - 1 < *p)
+            {
+                ok = false;
+                return string();
+            }
+            string s(reinterpret_cast<const char*>(p + 1), *p);
+            p += 1 + *p;
+            return s;
+        };
+        int nDict = p < end ? *p++ : 0;
+        for (int n = 0; n < nDict && ok; n++)
+            g.dict.push_back(name());
+        int nColumns = p < end ? *p++ : 0;
+        vector<int> ids;
+        vector<size_t> sizes;
+        for (int n = 0; n < nColumns && ok; n++)
+        {
+            ids.push_back(resultColumn(name()));
+            if (end - p < 4)
+                ok = false;
+            else
+            {
+                sizes.push_back(getU32(p));
+                p += 4;
+            }
+        }
+        for (size_t n = 0; n < sizes.size() && ok; n++)
+        {
+            if (static_cast<size_t>(end - p) < sizes[n])
+                ok = false;
+            else if (ids[n] >= 0)
+            {
+                g.data[ids[n]] = p;
+                g.size[ids[n]] = sizes[n];
+            }
+            p += sizes[n];
+        }
+        if (!ok)
+            break;
+        m_groups.push_back(g);
+    }
+    return true;
+}
+
+//####################
+// Decodes one column of one group;
+// a column the group lacks reads as zeros
+//####################
+void ResultFile::decode(size_t g, int column, vector<int64_t>& values) const
+{
+    const Group& group = m_groups[g];
+    values.assign(group.nRows, 0);
+    const unsigned char* p = group.data[column];
+    if (p == nullptr)
+        return;
+    const unsigned char* end = p + group.size[column];
+
+    int64_t prev = 0;
+    for (int n = 0; n < group.nRows && p < end; n++)
+    {
+        // A value takes at most 10 bytes; a longer run is corrupt,
+        // and the rest of the column reads as zeros
+        uint64_t v = 0;
+        int shift = 0;
+        while (p < end && (*p & 0x80) && shift < 63)
+        {
+            v |= uint64_t(*p++ & 0x7F) << shift;
+            shift += 7;
+        }
+        if (p >= end || (*p & 0x80))
+            return;
+        v |= uint64_t(*p++) << shift;
+        prev = static_cast<int64_t>(uint64_t(prev) + uint64_t(unzigzag(v)));  // wraps if corrupt
+        values[n] = prev;
+    }
+}
@@ -0,0 +1,110 @@
+#ifndef RESULTSTORE_INCLUDED
+#define RESULTSTORE_INCLUDED
+
+#include "utility.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <cstdint>
+
+struct GameRecord;
+struct PlayerClock;
+
+  // One row per player per game, seen from that player's side
+enum ResultColumn {
+    COL_GAME, COL_SEED, COL_ROWS, COL_COLS,
+    COL_STRATEGY, COL_OPPONENT,      // dictionary ids
+    COL_FIRST, COL_WON, COL_SHOTS,
+    COL_OWNVERT, COL_OPPVERT,        // bit n set if ship n is vertical
+    COL_OWNEDGE, COL_OPPEDGE,        // ships touching an edge
+    COL_US, COL_CALLS, COL_MAXUS,    // in-call time, and the slowest call
+    COL_CPUUS, COL_PEAKBYTES,
+    NRESULTCOLUMNS
+};
+
+extern const char* const RESULT_COLUMN_NAMES[NRESULTCOLUMNS];
+
+  // Column number for a name, or -1
+int resultColumn(const std::string& name);
+
+  // Columnar result files
+  //
+  // An 8-byte header ("BSRC", version, 3 reserved bytes) is followed
+  // by row groups of up to ROWS_PER_GROUP rows. Each group is a u32
+  // byte count, u32 row count, u8 dictionary size and names, u8 column
+  // count, then per column its name and u32 data size, then the column
+  // data. Every column is zigzag-encoded deltas between successive rows,
+  // written as varints. Files are appendable; readers skip columns they
+  // don't know and read missing ones as 0.
+const int RESULT_VERSION = 1;
+
+  // Appends rows from any number of threads
+  //
+  // Rows are only buffered under the lock; a full group is handed to
+  // a writer thread, which encodes it and writes it to disk
+class ResultWriter
+{
+  public:
+    static const int ROWS_PER_GROUP = 1 << 16;
+
+    ResultWriter();
+    ~ResultWriter();
+    bool open(const std::string& path);
+      // Adds both players' rows; types and clocks are in turn order
+    void addGame(const GameRecord& record, long long game,
+                 const std::string types[2], const PlayerClock clocks[2]);
+    void close();
+    ResultWriter(const ResultWriter&) = delete;
+    ResultWriter& operator=(const ResultWriter&) = delete;
+
+  private:
+    struct Group
+    {
+        int nRows = 0;
+        std::vector<std::string> dict;
+        std::vector<std::int64_t> columns[NRESULTCOLUMNS];
+    };
+    int intern(const std::string& name);
+    void writeGroup(const Group& group);
+    void writerLoop();
+
+    std::ofstream m_file;
+    std::thread m_thread;
+    std::mutex m_lock;
+    std::condition_variable m_wake;
+    Group m_group;              // filled by addGame
+    std::deque<Group> m_full;   // groups waiting for the writer thread
+    bool m_open;
+    bool m_closing;
+};
+
+  // Row groups of a result file, mapped into memory
+  //
+  // Safe to decode from many threads at once
+class ResultFile
+{
+  public:
+    bool open(const std::string& path);
+    std::size_t nGroups() const { return m_groups.size(); }
+    int groupRows(std::size_t g) const { return m_groups[g].nRows; }
+    const std::vector<std::string>& groupDict(std::size_t g) const { return m_groups[g].dict; }
+      // Decodes one column of one group into values
+    void decode(std::size_t g, int column, std::vector<std::int64_t>& values) const;
+
+  private:
+    struct Group
+    {
+        int nRows;
+        std::vector<std::string> dict;
+        const unsigned char* data[NRESULTCOLUMNS];   // nullptr if absent
+        std::size_t size[NRESULTCOLUMNS];
+    };
+    MappedFile m_file;
+    std::vector<Group> m_groups;
+};
+
+#endif // RESULTSTORE_INCLUDED
@@ -0,0 +1,309 @@
+#include "Shard.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+    const char* const PARTIAL_MAGIC = "BSPART";
+    const int PARTIAL_VERSION = 1;
+}
+
+PartialGame::PartialGame() : latency(2), calibration(2) {}
+
+void PartialGame::clear()
+{
+    state.clear();
+    latency.assign(2, LatencyTable());
+    calibration.assign(2, CalibrationTable());
+}
+
+//####################
+// Writes one line per side's nonempty histogram, under
+// histKey for latencies and calibKey for calibration
+//####################
+static void writeTables(ostream& out, const char* histKey, const char* calibKey,
+                        const vector<LatencyTable>& latency, const vector<CalibrationTable>& calibration)
+{
+    for (size_t side = 0; side < latency.size() && side < 2; side++)
+        for (int k = 0; k < NCALLKINDS; k++)
+            for (int p = 0; p < NPHASES; p++)
+            {
+                const LatencyHistogram& h = latency[side].histograms[k][p];
+                if (h.count() == 0)
+                    continue;
+                out << histKey << ' ' << side << ' ' << k << ' ' << p << ' ';
+                h.save(out);
+                out << '\n';
+            }
+    for (size_t side = 0; side < calibration.size() && side < 2; side++)
+        for (int p = 0; p < NPHASES; p++)
+        {
+            const CalibrationHistogram& h = calibration[side].phases[p];
+            if (h.count() == 0)
+                continue;
+            out << calibKey << ' ' << side << ' ' << p << ' ';
+            h.save(out);
+            out << '\n';
+        }
+}
+
+//####################
+// Reads the rest of a histogram line into latency
+// Returns false if it is malformed
+//####################
+static bool readHist(istream& fields, vector<LatencyTable>& latency)
+{
+    int side, k, p;
+    return fields >> side >> k >> p && side >= 0 && side < 2 && k >= 0 && k < NCALLKINDS &&
+           p >= 0 && p < NPHASES && latency[side].histograms[k][p].load(fields);
+}
+
+//####################
+// Reads the rest of a calibration line into calibration
+// Returns false if it is malformed
+//####################
+static bool readCalib(istream& fields, vector<CalibrationTable>& calibration)
+{
+    int side, p;
+    return fields >> side >> p && side >= 0 && side < 2 && p >= 0 && p < NPHASES &&
+           calibration[side].phases[p].load(fields);
+}
+
+int shardGames(int nGames, int shard, int nShards)
+{
+    if (nShards < 1)
+        nShards = 1;
+    return shard < 0 || shard >= nShards || nGames <= shard ? 0 : (nGames - shard - 1) / nShards + 1;
+}
+
+//####################
+// Replaces the partial file at path with the results so far
+// Returns false if it can't be written
+//####################
+bool writePartial(const string& path, const TournamentConfig& config,
+                  const TournamentResult& result, const PartialGame* game)
+{
+    string temp = path + ".tmp";
+    {
+        ofstream out(temp);
+        if (!out)
+            return false;
+        out << setprecision(17);
+        out << PARTIAL_MAGIC << ' ' << PARTIAL_VERSION << '\n'
+            << "types " << config.types[0] << ' ' << config.types[1] << '\n'
+            << "size " << config.rows << ' ' << config.cols << '\n'
+            << "games " << config.nGames << '\n'
+            << "seed " << result.seed << '\n'
+            << "limits " << config.moveLimitMs << ' ' << config.gameLimitMs << ' '
+            << static_cast<int>(config.policy) << '\n'
+            << "learning " << config.placementCandidates << ' ' << config.modelDir << '\n'
+            << "shards " << result.nShards;
+        for (int shard : result.shards)
+            out << ' ' << shard;
+        out << '\n'
+            << "played " << result.nGames << ' ' << result.nUndecided << ' ' << result.wallMs << '\n';
+        for (int side = 0; side < 2; side++)
+        {
+            const StrategyStats& st = result.stats[side];
+            out << "side " << side << ' ' << st.wins << ' ' << st.timeMs << ' ' << st.calls << ' '
+                << st.timeouts << ' ' << st.cpuMs << ' ' << st.allocs << ' ' << st.allocBytes << ' '
+                << st.peakBytesSum << ' ' << st.peakBytesMax << '\n';
+        }
+        writeTables(out, "hist", "calib", result.latency, result.calibration);
+        if (game != nullptr && !game->state.empty())
+        {
+            out << "game " << game->state << '\n';
+            writeTables(out, "gamehist", "gamecalib", game->latency, game->calibration);
+        }
+        out << "end\n";
+        out.close();
+        if (!out)
+            return false;
+    }
+    return rename(temp.c_str(), path.c_str()) == 0;
+}
+
+//####################
+// Reads a partial file into config and result
+// Returns false if it is missing, truncated or malformed
+//####################
+bool readPartial(const string& path, TournamentConfig& config,
+                 TournamentResult& result, PartialGame* game)
+{
+    ifstream in(path);
+    string magic;
+    int version;
+    if (!(in >> magic >> version) || magic != PARTIAL_MAGIC || version != PARTIAL_VERSION)
+        return false;
+
+    result = TournamentResult();
+    result.latency.resize(2);
+    result.calibration.resize(2);
+    PartialGame ignored;
+    if (game == nullptr)
+        game = &ignored;
+    game->clear();
+    string line;
+    getline(in, line);
+    bool ended = false;
+    while (!ended && getline(in, line))
+    {
+        istringstream fields(line);
+        string key;
+        fields >> key;
+        bool ok = true;
+        if (key == "types")
+            ok = static_cast<bool>(fields >> config.types[0] >> config.types[1]);
+        else if (key == "size")
+            ok = static_cast<bool>(fields >> config.rows >> config.cols);
+        else if (key == "games")
+            ok = static_cast<bool>(fields >> config.nGames);
+        else if (key == "seed")
+            ok = static_cast<bool>(fields >> result.seed);
+        else if (key == "limits")
+        {
+            int policy;
+            ok = static_cast<bool>(fields >> config.moveLimitMs >> config.gameLimitMs >> policy);
+            config.policy = static_cast<TimeoutPolicy>(policy);
+        }
+        else if (key == "learning")
+        {
+            ok = static_cast<bool>(fields >> config.placementCandidates);
+            getline(fields >> ws, config.modelDir);
+        }
+        else if (key == "shards")
+        {
+            ok = static_cast<bool>(fields >> result.nShards);
+            int shard;
+            while (fields >> shard)
+                result.shards.push_back(shard);
+        }
+        else if (key == "played")
+            ok = static_cast<bool>(fields >> result.nGames >> result.nUndecided >> result.wallMs);
+        else if (key == "side")
+        {
+            int side;
+            ok = fields >> side && side >= 0 && side < 2;
+            if (ok)
+            {
+                StrategyStats& st = result.stats[side];
+                ok = static_cast<bool>(fields >> st.wins >> st.timeMs >> st.calls >> st.timeouts >> st.cpuMs
+                                              >> st.allocs >> st.allocBytes >> st.peakBytesSum >> st.peakBytesMax);
+            }
+        }
+        else if (key == "hist")
+            ok = readHist(fields, result.latency);
+        else if (key == "calib")
+            ok = readCalib(fields, result.calibration);
+        else if (key == "game")
+            getline(fields >> ws, game->state);
+        else if (key == "gamehist")
+            ok = readHist(fields, game->latency);
+        else if (key == "gamecalib")
+            ok = readCalib(fields, game->calibration);
+        else if (key == "end")
+            ended = true;
+        // Lines with other keys are left for later versions
+        if (!ok)
+            return false;
+    }
+    if (!ended)
+        return false;
+
+    config.seed = result.seed;
+    config.nShards = result.nShards;
+    config.shard = result.shards.size() == 1 ? result.shards[0] : 0;
+    result.rows = config.rows;
+    result.cols = config.cols;
+    result.nCap = config.nGames;
+    for (int side = 0; side < 2; side++)
+        result.stats[side].type = config.types[side];
+    return true;
+}
+
+bool sameShard(const TournamentConfig& a, const TournamentConfig& b)
+{
+    return a.types[0] == b.types[0] && a.types[1] == b.types[1] &&
+           a.rows == b.rows && a.cols == b.cols && a.nGames == b.nGames &&
+           a.seed == b.seed && a.moveLimitMs == b.moveLimitMs &&
+           a.gameLimitMs == b.gameLimitMs && a.policy == b.policy &&
+           max(a.nShards, 1) == max(b.nShards, 1) && a.shard == b.shard &&
+           a.modelDir == b.modelDir && a.placementCandidates == b.placementCandidates;
+}
+
+//####################
+// Sums the partial files at paths
+//
+// Wall time is the longest shard's, since shards run
+// side by side
+//####################
+bool mergePartials(const vector<string>& paths, TournamentConfig& config,
+                   TournamentResult& total, string& error)
+{
+    if (paths.empty())
+    {
+        error = "no partial files";
+        return false;
+    }
+    for (size_t n = 0; n < paths.size(); n++)
+    {
+        TournamentConfig partConfig("", "", 0);
+        TournamentResult part;
+        if (!readPartial(paths[n], partConfig, part))
+        {
+            error = "cannot read " + paths[n];
+            return false;
+        }
+        if (n == 0)
+        {
+            config = partConfig;
+            total = part;
+            continue;
+        }
+
+        // Same tournament, whatever the shard
+        partConfig.shard = config.shard;
+        if (!sameShard(config, partConfig))
+        {
+            error = paths[n] + " is from another tournament than " + paths[0];
+            return false;
+        }
+        for (int shard : part.shards)
+        {
+            if (find(total.shards.begin(), total.shards.end(), shard) != total.shards.end())
+            {
+                error = paths[n] + " repeats shard " + to_string(shard);
+                return false;
+            }
+            total.shards.push_back(shard);
+        }
+
+        total.nGames += part.nGames;
+        total.nUndecided += part.nUndecided;
+        total.wallMs = max(total.wallMs, part.wallMs);
+        for (int side = 0; side < 2; side++)
+        {
+            StrategyStats& st = total.stats[side];
+            const StrategyStats& from = part.stats[side];
+            st.wins += from.wins;
+            st.timeMs += from.timeMs;
+            st.calls += from.calls;
+            st.timeouts += from.timeouts;
+            st.cpuMs += from.cpuMs;
+            st.allocs += from.allocs;
+            st.allocBytes += from.allocBytes;
+            st.peakBytesSum += from.peakBytesSum;
+            st.peakBytesMax = max(st.peakBytesMax, from.peakBytesMax);
+            total.latency[side].merge(part.latency[side]);
+            total.calibration[side].merge(part.calibration[side]);
+        }
+    }
+    sort(total.shards.begin(), total.shards.end());
+    config.shard = total.shards.size() == 1 ? total.shards[0] : 0;
+    return true;
+}
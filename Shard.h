@@ -0,0 +1,52 @@
+#ifndef SHARD_INCLUDED
+#define SHARD_INCLUDED
+
+#include "Tournament.h"
+#include <string>
+#include <vector>
+
+  // Partial result files of a sharded tournament
+  //
+  // A partial file is text: a version line, then one "key value..."
+  // line per setting, counter and nonempty latency or calibration
+  // histogram, and lines for the game in progress if any, ending with
+  // "end". It holds everything printTournament shows, so
+  // partial files from every shard merge into exactly the totals a
+  // single run would have counted. Files are replaced by renaming
+  // a complete copy, so a killed shard leaves the last one intact.
+
+  // Games of the tournament that belong to one shard
+int shardGames(int nGames, int shard, int nShards);
+
+  // A shard's next game part-way through: its state (see
+  // Game::saveState), if not empty, and the calls and shots it has
+  // timed so far, per side; these join the result's histograms only
+  // once the game is over, so a game that can't be resumed and is
+  // played again is not counted twice
+struct PartialGame
+{
+    PartialGame();
+    void clear();
+
+    std::string state;
+    std::vector<LatencyTable> latency;
+    std::vector<CalibrationTable> calibration;
+};
+
+  // Nothing of game, if given, is in result
+bool writePartial(const std::string& path, const TournamentConfig& config,
+                  const TournamentResult& result, const PartialGame* game = nullptr);
+bool readPartial(const std::string& path, TournamentConfig& config,
+                 TournamentResult& result, PartialGame* game = nullptr);
+
+  // Whether two configurations describe the same tournament and
+  // shard, so that a run of one may resume the other's partial file
+bool sameShard(const TournamentConfig& a, const TournamentConfig& b);
+
+  // Sums the partial files of one tournament's shards into total
+  // Returns false, with the reason in error, if a file can't be read,
+  // belongs to another tournament or repeats a shard
+bool mergePartials(const std::vector<std::string>& paths, TournamentConfig& config,
+                   TournamentResult& total, std::string& error);
+
+#endif // SHARD_INCLUDED
@@ -0,0 +1,156 @@
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -pthread Shard/shard.cpp Accounting.cpp Board.cpp Capture.cpp Game.cpp GameRecord.cpp Histogram.cpp OpponentModel.cpp Player.cpp ResultStore.cpp Shard.cpp Sprt.cpp Tournament.cpp Trace.cpp utility.cpp
+//
+// Usage:
+//   shard run type1 type2 games seed shard nShards partial
+//   shard fork type1 type2 games seed nShards prefix
+//   shard merge partial...
+//
+// run plays one shard of a tournament, saving its results to the
+// partial file every quarter second; run it again with the same
+// arguments to resume a shard that was killed. Shards may run on any machine
+// that can write the partial file somewhere merge can read it.
+//
+// fork runs every shard in its own child process on this machine,
+// writing prefix.0 ... prefix.<nShards-1>. A child that crashes or is
+// killed is started again and resumes where it stopped, up to 3 times.
+// The merged results are then printed.
+//
+// merge prints the combined results of any set of shards' partial files.
+
+#include "../Tournament.h"
+#include "../Shard.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+const int MAXRESTARTS = 3;
+
+int mergeAndPrint(const vector<string>& paths)
+{
+    TournamentConfig config("", "", 0);
+    TournamentResult total;
+    string error;
+    if (!mergePartials(paths, config, total, error))
+    {
+        cerr << "Cannot merge: " << error << endl;
+        return 1;
+    }
+    printTournament(total, cout);
+    return 0;
+}
+
+//######################
+// Runs one shard in a child process
+// Returns its process id, or -1
+//######################
+pid_t startShard(const TournamentConfig& config)
+{
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        TournamentResult result = runTournament(config);
+        _exit(result.nShards > 0 ? 0 : 1);
+    }
+    return pid;
+}
+
+int forkShards(TournamentConfig config, const string& prefix)
+{
+    int nShards = config.nShards;
+    vector<pid_t> pids(nShards, -1);
+    vector<int> restarts(nShards, 0);
+    vector<string> paths;
+    vector<TournamentConfig> configs;
+    for (int shard = 0; shard < nShards; shard++)
+    {
+        config.shard = shard;
+        config.partialPath = prefix + "." + to_string(shard);
+        configs.push_back(config);
+        paths.push_back(config.partialPath);
+        pids[shard] = startShard(config);
+        if (pids[shard] < 0)
+        {
+            cerr << "Cannot start shard " << shard << endl;
+            return 1;
+        }
+    }
+
+    int nRunning = nShards;
+    int failed = 0;
+    while (nRunning > 0)
+    {
+        int status;
+        pid_t pid = wait(&status);
+        if (pid < 0)
+            break;
+        int shard = 0;
+        while (shard < nShards && pids[shard] != pid)
+            shard++;
+        if (shard == nShards)
+            continue;
+        pids[shard] = -1;
+        bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        if (!ok && restarts[shard] < MAXRESTARTS)
+        {
+            restarts[shard]++;
+            cerr << "Shard " << shard << " died; resuming it (restart " << restarts[shard] << ")" << endl;
+            pids[shard] = startShard(configs[shard]);
+            if (pids[shard] >= 0)
+                continue;
+        }
+        if (!ok)
+        {
+            cerr << "Shard " << shard << " failed" << endl;
+            failed++;
+        }
+        nRunning--;
+    }
+    int merged = mergeAndPrint(paths);
+    return failed > 0 ? 1 : merged;
+}
+
+int main(int argc, char* argv[])
+{
+    string mode = argc > 1 ? argv[1] : "";
+    if (mode == "merge" && argc > 2)
+        return mergeAndPrint(vector<string>(argv + 2, argv + argc));
+    if ((mode == "run" && argc == 9) || (mode == "fork" && argc == 8))
+    {
+        TournamentConfig config(argv[2], argv[3], atoi(argv[4]));
+        config.seed = strtoul(argv[5], nullptr, 0);
+        if (config.seed == 0)
+        {
+            cerr << "The seed must not be 0" << endl;
+            return 2;
+        }
+        if (mode == "fork")
+        {
+            config.nShards = atoi(argv[6]);
+            if (config.nShards < 1)
+            {
+                cerr << "Need at least one shard" << endl;
+                return 2;
+            }
+            return forkShards(config, argv[7]);
+        }
+        config.shard = atoi(argv[6]);
+        config.nShards = atoi(argv[7]);
+        config.partialPath = argv[8];
+        TournamentResult result = runTournament(config);
+        if (result.nShards == 0)
+            return 1;
+        printTournament(result, cout);
+        return 0;
+    }
+    cerr << "Usage: shard run type1 type2 games seed shard nShards partial" << endl
+         << "       shard fork type1 type2 games seed nShards prefix" << endl
+         << "       shard merge partial..." << endl;
+    return 2;
+}
@@ -0,0 +1,58 @@
+#include "Sprt.h"
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+    // z with P(Z > z) = q for a standard normal Z, by bisection
+    double upperQuantile(double q)
+    {
+        double lo = -10, hi = 10;
+        for (int i = 0; i < 100; i++)
+        {
+            double mid = (lo + hi) / 2;
+            if (0.5 * erfc(mid / sqrt(2.0)) > q)
+                lo = mid;
+            else
+                hi = mid;
+        }
+        return (lo + hi) / 2;
+    }
+}
+
+Sprt::Sprt(double alpha, double beta, double delta)
+ : m_alpha(alpha), m_beta(beta), m_delta(delta),
+   m_lower(log(beta / (1 - alpha))), m_upper(log((1 - beta) / alpha))
+{}
+
+//####################
+// Log-likelihood ratio of H1 to H0
+//####################
+double Sprt::llr(long long wins, long long losses) const
+{
+    double p0 = 0.5 - m_delta;
+    double p1 = 0.5 + m_delta;
+    return wins * log(p1 / p0) + losses * log((1 - p1) / (1 - p0));
+}
+
+Sprt::Decision Sprt::decide(long long wins, long long losses) const
+{
+    double ratio = llr(wins, losses);
+    if (ratio >= m_upper)
+        return FIRST_BETTER;
+    if (ratio <= m_lower)
+        return SECOND_BETTER;
+    return CONTINUE;
+}
+
+//####################
+// Size of a one-shot test of the same two hypotheses:
+// pick the first strategy if it wins over half the games
+//####################
+long long Sprt::fixedGames() const
+{
+    double z = upperQuantile(m_alpha) + upperQuantile(m_beta);
+    double sd = sqrt(0.25 - m_delta * m_delta);
+    return static_cast<long long>(ceil(z * z * sd * sd / (4 * m_delta * m_delta)));
+}
@@ -0,0 +1,33 @@
+#ifndef SPRT_INCLUDED
+#define SPRT_INCLUDED
+
+  // Sequential probability ratio test on a stream of decisive games
+  //
+  // Tests H0: the first strategy wins with probability 0.5 - delta
+  // against H1: it wins with probability 0.5 + delta. alpha is the chance
+  // of wrongly picking the first strategy, beta of wrongly picking the
+  // second. Draws carry no information and are left out.
+class Sprt
+{
+  public:
+    enum Decision {
+        CONTINUE, FIRST_BETTER, SECOND_BETTER
+    };
+
+    Sprt(double alpha = 0.05, double beta = 0.05, double delta = 0.05);
+    Decision decide(long long wins, long long losses) const;
+    double llr(long long wins, long long losses) const;
+    double lowerBound() const { return m_lower; }
+    double upperBound() const { return m_upper; }
+      // Decisive games a fixed-size test with the same error rates needs
+    long long fixedGames() const;
+
+  private:
+    double m_alpha;
+    double m_beta;
+    double m_delta;
+    double m_lower;
+    double m_upper;
+};
+
+#endif // SPRT_INCLUDED
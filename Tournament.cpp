@@ -0,0 +1,685 @@
+#include "Tournament.h"
+#include "Game.h"
+#include "Player.h"
+#include "Board.h"
+#include "utility.h"
+#include "Trace.h"
+#include "Capture.h"
+#include "OpponentModel.h"
+#include "GameRecord.h"
+#include "ResultStore.h"
+#include "Shard.h"
+#include <random>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <fstream>
+#include <sstream>
+#include <functional>
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+bool addStandardShips(Game& g)
+{
+    return g.addShip(5, 'A', "aircraft carrier")  &&
+           g.addShip(4, 'B', "battleship")  &&
+           g.addShip(3, 'D', "destroyer")  &&
+           g.addShip(3, 'S', "submarine")  &&
+           g.addShip(2, 'P', "patrol boat");
+}
+
+TournamentConfig::TournamentConfig(string type1, string type2, int nGames)
+ : types{ type1, type2 }, nGames(nGames), rows(10), cols(10), nThreads(0),
+   moveLimitMs(0), gameLimitMs(0), policy(FORFEIT), seed(0),
+   placementCandidates(256), sprtDelta(0), sprtAlpha(0.05), sprtBeta(0.05), batchSize(100),
+   shard(0), nShards(1)
+{}
+
+// A partial file takes about half a millisecond to save, so
+// it is saved at most this often, and after the last game
+const double PARTIAL_SAVE_MS = 250;
+
+//####################
+// Plays game number k (1-based) of a tournament
+// and adds its outcome to result
+// 
+// models, if given, hold where each side's type places
+// ships: each side plays with the other's as a prior,
+// and the game's placements are added to them
+// 
+// If partial is given the game carries on from its state,
+// if any, or starts over if it can't be loaded; the game's
+// calls and shots are timed into partial until it is over,
+// and it is cleared then. checkpoint, if set, is called
+// now and then between turns
+// Returns the winning side, or -1
+//####################
+static int playOne(const TournamentConfig& config, int k, unsigned seed,
+                   RecordWriter* writer, ResultWriter* results, OpponentModel* const* models,
+                   TournamentResult& result, PartialGame* partial = nullptr,
+                   function<void(const Game&)> checkpoint = nullptr)
+{
+    Game g(config.rows, config.cols);
+    addStandardShips(g);
+    g.setVerbose(false);
+    g.setTimeControl(config.moveLimitMs, config.gameLimitMs, config.policy);
+    g.setSeed(seed + k);
+    g.setRecordWriter(writer);
+    if (checkpoint)
+        g.setCheckpoint(PARTIAL_SAVE_MS, [&] { checkpoint(g); });
+
+    // Each side expects the other to place ships and fire as it has before
+    OpponentPrior priors[2];
+    for (int side = 0; side < 2; side++)
+        if (models != nullptr && models[1 - side] != nullptr)
+        {
+            models[1 - side]->prior(priors[side]);
+            priors[side].candidates = config.placementCandidates;
+        }
+
+    Player* players[2];
+    auto create = [&]()
+    {
+        for (int side = 0; side < 2; side++)
+        {
+            players[side] = createPlayer(config.types[side], config.types[side] + to_string(side + 1), g);
+            LatencyTable* latency = partial != nullptr ? &partial->latency[side] : &result.latency[side];
+            CalibrationTable* calibration =
+                partial != nullptr ? &partial->calibration[side] : &result.calibration[side];
+            g.setLatencyTable(players[side], latency);
+            g.setCalibrationTable(players[side], calibration);
+            if (models != nullptr && models[1 - side] != nullptr)
+                players[side]->useOpponentPrior(&priors[side]);
+        }
+    };
+    create();
+
+    // Odd games player 1 goes first, even games player 2
+    Player* first = players[k % 2 == 1 ? 0 : 1];
+    Player* second = players[k % 2 == 1 ? 1 : 0];
+    Player* winner = nullptr;
+    bool loaded = false;
+    if (partial != nullptr && !partial->state.empty())
+    {
+        istringstream in(partial->state);
+        winner = g.resume(first, second, in, loaded, false);
+        if (!loaded)
+        {
+            // What it timed before the checkpoint is timed again
+            cerr << "Cannot resume game " << k << "; playing it again" << endl;
+            for (int side = 0; side < 2; side++)
+                delete players[side];
+            partial->clear();
+            create();
+            first = players[k % 2 == 1 ? 0 : 1];
+            second = players[k % 2 == 1 ? 1 : 0];
+        }
+    }
+    if (!loaded)
+        winner = g.play(first, second, false);
+
+    // The record lists players in turn order
+    for (int side = 0; side < 2; side++)
+        if (models != nullptr && models[side] != nullptr)
+            models[side]->record(g.lastRecord(), (side == 0) == (k % 2 == 1) ? 0 : 1);
+
+    if (results != nullptr)
+    {
+        int first = k % 2 == 1 ? 0 : 1;
+        string types[2] = { config.types[first], config.types[1 - first] };
+        PlayerClock clocks[2] = { g.playerClock(players[first]), g.playerClock(players[1 - first]) };
+        results->addGame(g.lastRecord(), k, types, clocks);
+    }
+
+    if (partial != nullptr)
+    {
+        for (int side = 0; side < 2; side++)
+        {
+            result.latency[side].merge(partial->latency[side]);
+            result.calibration[side].merge(partial->calibration[side]);
+        }
+        partial->clear();
+    }
+
+    result.nGames++;
+    if (winner == nullptr)
+        result.nUndecided++;
+    int winningSide = winner == nullptr ? -1 : (winner == players[0] ? 0 : 1);
+    for (int side = 0; side < 2; side++)
+    {
+        StrategyStats& st = result.stats[side];
+        PlayerClock clock = g.playerClock(players[side]);
+        if (winner == players[side])
+            st.wins++;
+        st.timeMs += clock.usedMs;
+        st.calls += clock.calls;
+        st.timeouts += clock.timeouts;
+        st.cpuMs += clock.cpuMs;
+        st.allocs += clock.heap.allocs;
+        st.allocBytes += clock.heap.bytes;
+        st.peakBytesSum += clock.heap.peakBytes;
+        if (clock.heap.peakBytes > st.peakBytesMax)
+            st.peakBytesMax = clock.heap.peakBytes;
+        delete players[side];
+    }
+    return winningSide;
+}
+
+//####################
+// Plays one shard's games in order on this thread,
+// saving a partial file as it goes if asked to
+//
+// A matching partial file already at that path is resumed
+// from, along with the game it caught part-way through;
+// anything played after it was saved is played again, and
+// being seeded comes out the same
+//####################
+static void playShard(const TournamentConfig& config, RecordWriter* writer,
+                      ResultWriter* results, OpponentModel* const* models, TournamentResult& total)
+{
+    int nShards = max(config.nShards, 1);
+    total.nShards = nShards;
+    total.shards.assign(1, config.shard);
+    bool saving = !config.partialPath.empty();
+
+    TournamentConfig saved("", "", 0);
+    TournamentResult done;
+    PartialGame partial;
+    if (saving && readPartial(config.partialPath, saved, done, &partial))
+    {
+        // A run without a seed takes the saved one
+        TournamentConfig wanted = config;
+        if (wanted.seed == 0)
+            wanted.seed = saved.seed;
+        if (!sameShard(wanted, saved))
+        {
+            cerr << config.partialPath << " holds another tournament or shard; not resuming it" << endl;
+            total.nShards = 0;
+            total.shards.clear();
+            return;
+        }
+        total = done;
+    }
+    else
+        partial.clear();
+
+    // Saves the results so far, with the game in progress if there is one
+    double startMs = total.wallMs;
+    Timer timer;
+    Timer sinceSave;
+    auto save = [&](const Game* g)
+    {
+        if (g != nullptr)
+        {
+            ostringstream state;
+            g->saveState(state);
+            partial.state = state.str();
+        }
+        total.wallMs = startMs + timer.elapsed();
+        if (saving && !writePartial(config.partialPath, config, total, g != nullptr ? &partial : nullptr))
+        {
+            cerr << "Cannot save partial results to " << config.partialPath << endl;
+            saving = false;
+        }
+        sinceSave.start();
+    };
+    function<void(const Game&)> checkpoint;
+    if (saving)
+        checkpoint = [&](const Game& g) { save(&g); };
+
+    for (int k = config.shard + 1 + total.nGames * nShards; k <= config.nGames; k += nShards)
+    {
+        playOne(config, k, total.seed, writer, results, models, total,
+                saving ? &partial : nullptr, checkpoint);
+        total.wallMs = startMs + timer.elapsed();
+        if (saving && (sinceSave.elapsed() >= PARTIAL_SAVE_MS || k + nShards > config.nGames))
+            save(nullptr);
+    }
+}
+
+//####################
+// Checks if a shard can be played as configured,
+// saying why not if it can't
+//####################
+static bool canShard(const TournamentConfig& config)
+{
+    if (config.nShards > 1 && config.seed == 0)
+        cerr << "Shards of a tournament need a common seed" << endl;
+    else if (config.shard < 0 || config.shard >= max(config.nShards, 1))
+        cerr << "No shard " << config.shard << " of " << config.nShards << endl;
+    else if (config.sprtDelta > 0)
+        cerr << "Shards can't stop early; leave sprtDelta at 0" << endl;
+    // A resumed shard plays again the games after its last save, which
+    // a record or result file or an opponent model would then hold twice
+    else if (!config.partialPath.empty() && (!config.recordPath.empty() || !config.resultsPath.empty()))
+        cerr << "A shard saving partial results can't append game records or results" << endl;
+    else if (!config.partialPath.empty() && !config.modelDir.empty())
+        cerr << "A shard saving partial results can't learn opponent models" << endl;
+    else
+        return true;
+    return false;
+}
+
+//####################
+// Plays every game of a tournament on a pool of threads
+// 
+// Each thread keeps its own totals and latency
+// histograms, merged at the end
+// 
+// With early stopping, the SPRT looks at games 1..n each time
+// that prefix has finished and n is a multiple of the batch size,
+// so the decision doesn't depend on thread timing. Games already
+// under way when it decides are finished and counted.
+//####################
+TournamentResult runTournament(const TournamentConfig& config)
+{
+    TournamentResult total = {};
+    total.rows = config.rows;
+    total.cols = config.cols;
+    total.latency.resize(2);
+    total.calibration.resize(2);
+    total.seed = config.seed != 0 ? config.seed : random_device()();
+    for (int side = 0; side < 2; side++)
+        total.stats[side].type = config.types[side];
+
+    bool sharded = config.nShards > 1 || !config.partialPath.empty();
+    if (sharded && !canShard(config))
+        return total;
+
+    RecordWriter writer;
+    bool recording = !config.recordPath.empty() && writer.open(config.recordPath);
+    if (!config.recordPath.empty() && !recording)
+        cerr << "Cannot append game records to " << config.recordPath << endl;
+
+    ResultWriter results;
+    bool storing = !config.resultsPath.empty() && results.open(config.resultsPath);
+    if (!config.resultsPath.empty() && !storing)
+        cerr << "Cannot append results to " << config.resultsPath << endl;
+
+    // One model per type, shared by every thread
+    OpponentModel learned[2];
+    OpponentModel* models[2] = { nullptr, nullptr };
+    if (!config.modelDir.empty())
+    {
+        Game g(config.rows, config.cols);
+        addStandardShips(g);
+        for (int side = 0; side < 2; side++)
+        {
+            string path = config.modelDir + "/" + config.types[side] + ".bsom";
+            if (side == 1 && config.types[1] == config.types[0])
+                models[1] = models[0];
+            else if (learned[side].open(path, g))
+                models[side] = &learned[side];
+            else
+                cerr << "Cannot use opponent model " << path << endl;
+        }
+    }
+
+    // A shard's games go on this thread, so it can save after each one
+    if (sharded)
+    {
+        bool traced = !config.tracePath.empty() && startTracing(config.tracePath);
+        bool captured = !config.capturePath.empty() && startCapture(config.capturePath);
+        {
+            TraceScope span("shard");
+            playShard(config, recording ? &writer : nullptr, storing ? &results : nullptr, models, total);
+        }
+        if (traced)
+            stopTracing();
+        if (captured)
+            stopCapture();
+        writer.close();
+        results.close();
+        return total;
+    }
+
+    int nThreads = config.nThreads > 0 ? config.nThreads : thread::hardware_concurrency();
+    if (nThreads < 1)
+        nThreads = 1;
+
+    Sprt sprt(config.sprtAlpha, config.sprtBeta, config.sprtDelta);
+    int batch = config.batchSize > 0 ? config.batchSize : 1;
+    total.sprt = config.sprtDelta > 0;
+    total.decision = Sprt::CONTINUE;
+    total.fixedGames = total.sprt ? sprt.fixedGames() : 0;
+    total.nCap = config.nGames;
+
+    // Winner of each game (-1 draw, -2 not finished) and the
+    // finished prefix, guarded by stopLock
+    vector<signed char> outcomes(config.nGames + 1, -2);
+    int prefix = 0;
+    long long prefixWins[2] = { 0, 0 };
+    mutex stopLock;
+    atomic<bool> stop(false);
+
+    auto finished = [&](int k, int winningSide)
+    {
+        lock_guard<mutex> lock(stopLock);
+        outcomes[k] = winningSide;
+        while (prefix < config.nGames && outcomes[prefix + 1] != -2)
+        {
+            prefix++;
+            if (outcomes[prefix] >= 0)
+                prefixWins[outcomes[prefix]]++;
+            if (!total.sprt || total.decision != Sprt::CONTINUE || (prefix % batch != 0 && prefix != config.nGames))
+                continue;
+            total.decision = sprt.decide(prefixWins[0], prefixWins[1]);
+            total.llr = sprt.llr(prefixWins[0], prefixWins[1]);
+            if (total.decision != Sprt::CONTINUE)
+            {
+                total.decidedAt = prefix;
+                stop = true;
+            }
+        }
+    };
+
+    atomic<int> nextGame(1);
+    mutex mergeLock;
+    auto worker = [&]()
+    {
+        TournamentResult local = {};
+        local.latency.resize(2);
+        local.calibration.resize(2);
+        for (int k = nextGame++; k <= config.nGames && !stop; k = nextGame++)
+        {
+            int winningSide = playOne(config, k, total.seed, recording ? &writer : nullptr,
+                                      storing ? &results : nullptr, models, local);
+            if (total.sprt)
+                finished(k, winningSide);
+        }
+
+        lock_guard<mutex> lock(mergeLock);
+        total.nGames += local.nGames;
+        total.nUndecided += local.nUndecided;
+        for (int side = 0; side < 2; side++)
+        {
+            total.stats[side].wins += local.stats[side].wins;
+            total.stats[side].timeMs += local.stats[side].timeMs;
+            total.stats[side].calls += local.stats[side].calls;
+            total.stats[side].timeouts += local.stats[side].timeouts;
+            total.stats[side].cpuMs += local.stats[side].cpuMs;
+            total.stats[side].allocs += local.stats[side].allocs;
+            total.stats[side].allocBytes += local.stats[side].allocBytes;
+            total.stats[side].peakBytesSum += local.stats[side].peakBytesSum;
+            if (local.stats[side].peakBytesMax > total.stats[side].peakBytesMax)
+                total.stats[side].peakBytesMax = local.stats[side].peakBytesMax;
+            total.latency[side].merge(local.latency[side]);
+            total.calibration[side].merge(local.calibration[side]);
+        }
+    };
+
+    bool traced = !config.tracePath.empty() && startTracing(config.tracePath);
+    bool captured = !config.capturePath.empty() && startCapture(config.capturePath);
+    if (!config.capturePath.empty() && !captured)
+        cerr << "Cannot capture moves to " << config.capturePath << endl;
+    Timer timer;
+    {
+        TraceScope span("tournament");
+        vector<thread> threads;
+        for (int t = 0; t < nThreads; t++)
+            threads.push_back(thread(worker));
+        for (thread& t : threads)
+            t.join();
+    }
+    total.wallMs = timer.elapsed();
+    if (traced)
+        stopTracing();
+    if (captured)
+        stopCapture();
+    writer.close();
+    results.close();
+    return total;
+}
+
+void printTournament(const TournamentResult& result, ostream& out)
+{
+    out << result.nGames << " games in " << fixed << setprecision(1)
+        << result.wallMs << " ms (" << result.nUndecided << " undecided), seed "
+        << result.seed << endl;
+    for (const StrategyStats& st : result.stats)
+    {
+        out << setw(10) << st.type << ": " << st.wins << " wins, "
+            << setprecision(1) << st.timeMs << " ms over " << st.calls << " calls ("
+            << setprecision(3) << (st.calls > 0 ? 1000 * st.timeMs / st.calls : 0)
+            << " us/call), " << st.timeouts << " timeouts" << endl;
+    }
+    int nGames = result.nGames > 0 ? result.nGames : 1;
+    for (const StrategyStats& st : result.stats)
+    {
+        out << setw(10) << st.type << ": " << setprecision(1) << st.cpuMs << " ms CPU, "
+            << st.allocs / nGames << " allocs (" << st.allocBytes / nGames << " bytes) per game, "
+            << "peak heap " << st.peakBytesSum / nGames << " bytes mean, "
+            << st.peakBytesMax << " max" << endl;
+    }
+
+    if (result.nShards > 1 || !result.shards.empty())
+    {
+        int expected = 0;
+        out << "Shards";
+        for (int shard : result.shards)
+        {
+            out << ' ' << shard;
+            expected += shardGames(result.nCap, shard, result.nShards);
+        }
+        out << " of " << result.nShards << ": " << result.nGames << " of their " << expected
+            << " games played" << endl;
+    }
+
+    if (result.sprt)
+    {
+        out << "SPRT (" << result.stats[0].type << " vs " << result.stats[1].type << "): ";
+        if (result.decision == Sprt::CONTINUE)
+            out << "undecided after " << result.nGames << " games, llr " << setprecision(2) << result.llr;
+        else
+            out << (result.decision == Sprt::FIRST_BETTER ? result.stats[0].type : result.stats[1].type)
+                << " is better, decided after " << result.decidedAt << " games (llr " << setprecision(2)
+                << result.llr << ")";
+        out << endl << "  played " << result.nGames << " games; saved " << result.nCap - result.nGames
+            << " of the " << result.nCap << "-game cap and " << result.fixedGames - result.nGames
+            << " of the " << result.fixedGames << " a fixed-size test needs" << endl;
+    }
+
+    string size = to_string(result.rows) + "x" + to_string(result.cols);
+    bool calibrated = false;
+    for (const CalibrationTable& table : result.calibration)
+        for (const CalibrationHistogram& h : table.phases)
+            calibrated = calibrated || h.count() > 0;
+    if (calibrated)
+    {
+        out << "Calibration of hit probabilities by strategy and phase:" << endl;
+        for (int side = 0; side < 2; side++)
+            if (side < static_cast<int>(result.calibration.size()))
+                result.calibration[side].print(result.stats[side].type + " " + size, out);
+    }
+
+    if (!LATENCY_HISTOGRAMS)
+        return;
+    out << "Latency by strategy, call and phase:" << endl;
+    for (int side = 0; side < 2; side++)
+        if (side < static_cast<int>(result.latency.size()))
+            result.latency[side].print(result.stats[side].type + " " + size, out);
+}
+
+//******************** Paired comparison functions ********************
+
+PairedConfig::PairedConfig(string type1, string type2, int nBoards)
+ : types{ type1, type2 }, nBoards(nBoards), rows(10), cols(10), nThreads(0), seed(0)
+{}
+
+//####################
+// Shots a strategy needs to sink the fleet placed on
+// fleet, on a fresh copy of it
+// Returns -1 if the player can't be built or has not
+// won after 4 shots per cell
+//####################
+static int shotsToSink(const Game& g, const Board& fleet, const string& type, unsigned seed)
+{
+    Board b(g);
+    for (int shipId = 0; shipId < g.nShips(); shipId++)
+    {
+        Point topOrLeft;
+        Direction dir;
+        if (!fleet.shipPosition(shipId, topOrLeft, dir) || !b.placeShip(topOrLeft, shipId, dir))
+            return -1;
+    }
+    Player* p = createPlayer(type, type, g);
+    if (p == nullptr)
+        return -1;
+
+    seedRandom(seed);
+    int shots = attackUntilSunk(*p, b);
+    delete p;
+    return b.allShipsDestroyed() ? shots : -1;
+}
+
+//####################
+// Places board k's fleet and has both strategies sink it
+// with the same random numbers
+//####################
+static void playBoard(const PairedConfig& config, int k, unsigned seed, int shots[2])
+{
+    shots[0] = shots[1] = -1;
+    Game g(config.rows, config.cols);
+    addStandardShips(g);
+    g.setVerbose(false);
+
+    // Odd boards the first strategy places the fleet, even boards the second
+    string placer = !config.opponent.empty() ? config.opponent : config.types[k % 2 == 1 ? 0 : 1];
+    Player* p = createPlayer(placer, placer, g);
+    if (p == nullptr)
+        return;
+    Board fleet(g);
+    seedRandom(2 * (seed + k));
+    bool placed = p->placeShips(fleet);
+    delete p;
+    if (!placed)
+        return;
+
+    for (int side = 0; side < 2; side++)
+        shots[side] = shotsToSink(g, fleet, config.types[side], 2 * (seed + k) + 1);
+}
+
+//####################
+// Plays every board of a paired comparison on a pool of
+// threads and summarizes the per-board differences
+//
+// Placement luck is shared by both strategies on each board, so
+// it cancels out of the difference; unpairedBoards estimates how
+// many independent boards per strategy would match its precision.
+//####################
+PairedResult runPaired(const PairedConfig& config)
+{
+    PairedResult result = {};
+    for (int side = 0; side < 2; side++)
+        result.types[side] = config.types[side];
+    result.seed = config.seed != 0 ? config.seed : random_device()();
+
+    int nThreads = config.nThreads > 0 ? config.nThreads : thread::hardware_concurrency();
+    if (nThreads < 1)
+        nThreads = 1;
+
+    // Each board's shots go in its own slot, so threads never share one
+    vector<int> shots(2 * (config.nBoards + 1), -1);
+    atomic<int> nextBoard(1);
+    auto worker = [&]()
+    {
+        for (int k = nextBoard++; k <= config.nBoards; k = nextBoard++)
+            playBoard(config, k, result.seed, &shots[2 * k]);
+    };
+
+    Timer timer;
+    {
+        TraceScope span("paired");
+        vector<thread> threads;
+        for (int t = 0; t < nThreads; t++)
+            threads.push_back(thread(worker));
+        for (thread& t : threads)
+            t.join();
+    }
+    result.wallMs = timer.elapsed();
+
+    ofstream out;
+    if (!config.outPath.empty())
+    {
+        out.open(config.outPath);
+        if (out)
+            out << "board\tplacer\t" << config.types[0] << "\t" << config.types[1] << "\tdelta" << endl;
+        else
+            cerr << "Cannot write per-board results to " << config.outPath << endl;
+    }
+
+    double sum[2] = { 0, 0 }, sum2[2] = { 0, 0 }, sumD = 0, sumD2 = 0;
+    for (int k = 1; k <= config.nBoards; k++)
+    {
+        const int* s = &shots[2 * k];
+        if (s[0] < 0 || s[1] < 0)
+        {
+            result.nFailed++;
+            continue;
+        }
+        int delta = s[0] - s[1];
+        result.nBoards++;
+        for (int side = 0; side < 2; side++)
+        {
+            sum[side] += s[side];
+            sum2[side] += double(s[side]) * s[side];
+        }
+        sumD += delta;
+        sumD2 += double(delta) * delta;
+        if (delta < 0)
+            result.nFewer++;
+        else if (delta > 0)
+            result.nMore++;
+        if (out.is_open())
+            out << k << '\t' << (!config.opponent.empty() ? config.opponent : config.types[k % 2 == 1 ? 0 : 1])
+                << '\t' << s[0] << '\t' << s[1] << '\t' << delta << '\n';
+    }
+
+    int n = result.nBoards;
+    if (n == 0)
+        return result;
+    auto sd = [n](double s, double s2) {
+        return n > 1 ? sqrt(max(0.0, (s2 - s * s / n) / (n - 1))) : 0.0;
+    };
+    for (int side = 0; side < 2; side++)
+    {
+        result.meanShots[side] = sum[side] / n;
+        result.sdShots[side] = sd(sum[side], sum2[side]);
+    }
+    result.meanDiff = sumD / n;
+    result.sdDiff = sd(sumD, sumD2);
+    double halfWidth = 1.96 * result.sdDiff / sqrt(double(n));
+    result.ciLow = result.meanDiff - halfWidth;
+    result.ciHigh = result.meanDiff + halfWidth;
+
+    // Independent samples need var0 + var1 where pairs need varDiff
+    double varDiff = result.sdDiff * result.sdDiff;
+    double varSum = result.sdShots[0] * result.sdShots[0] + result.sdShots[1] * result.sdShots[1];
+    result.unpairedBoards = varDiff > 0 ? static_cast<long long>(ceil(n * varSum / varDiff)) : 0;
+    return result;
+}
+
+void printPaired(const PairedResult& result, ostream& out)
+{
+    out << result.nBoards << " paired boards in " << fixed << setprecision(1)
+        << result.wallMs << " ms (" << result.nFailed << " failed), seed " << result.seed << endl;
+    if (result.nBoards == 0)
+        return;
+    for (int side = 0; side < 2; side++)
+        out << setw(10) << result.types[side] << ": " << setprecision(2) << result.meanShots[side]
+            << " shots to win, sd " << result.sdShots[side] << endl;
+    out << "  " << result.types[0] << " - " << result.types[1] << ": " << showpos << result.meanDiff
+        << noshowpos << " shots per board, 95% CI [" << result.ciLow << ", " << result.ciHigh
+        << "], sd " << result.sdDiff << endl;
+    out << "  " << result.types[0] << " needs fewer shots on " << result.nFewer << " boards, more on "
+        << result.nMore << ", same on " << result.nBoards - result.nFewer - result.nMore << endl;
+    if (result.unpairedBoards > 0)
+        out << "  unpaired games would need about " << result.unpairedBoards
+            << " boards per strategy for the same precision" << endl;
+}
@@ -0,0 +1,145 @@
+#ifndef TOURNAMENT_INCLUDED
+#define TOURNAMENT_INCLUDED
+
+#include "Game.h"
+#include "Histogram.h"
+#include "Sprt.h"
+#include <string>
+#include <vector>
+#include <iostream>
+
+class Game;
+
+bool addStandardShips(Game& g);
+
+  // A match of nGames games with the standard fleet between two
+  // player types, alternating who moves first
+struct TournamentConfig
+{
+    TournamentConfig(std::string type1, std::string type2, int nGames);
+    std::string types[2];
+    int nGames;
+    int rows;            // board size, 10x10 by default
+    int cols;
+    std::string tracePath;  // if not empty, write a timeline of the tournament here
+    std::string capturePath;  // if not empty, capture GoodPlayer's moves here (see Capture.h)
+    int nThreads;        // 0 uses every hardware thread
+    double moveLimitMs;  // 0 means unlimited
+    double gameLimitMs;  // 0 means unlimited
+    TimeoutPolicy policy;
+    unsigned seed;       // game k is seeded with seed + k; 0 picks a seed
+    std::string recordPath;  // if not empty, append a record of every game here
+    std::string resultsPath; // if not empty, append per-game results in columns here;
+                             // neither is available with a partialPath
+    std::string modelDir;    // if not empty, learn where each type places its ships
+                             // and fires early in modelDir/<type>.bsom and use it
+                             // against that type (see OpponentModel.h); games then
+                             // depend on what was learned before them, not only
+                             // on the seed; not available with a partialPath
+    int placementCandidates; // fleets a learning player samples to find the one
+                             // least exposed to early shots, 256 by default;
+                             // placing takes time in proportion
+
+      // Early stopping: with sprtDelta > 0 the match ends once an SPRT
+      // (see Sprt.h) decides, checked every batchSize games; nGames
+      // is then only a cap
+    double sprtDelta;
+    double sprtAlpha;
+    double sprtBeta;
+    int batchSize;
+
+      // Sharding: with nShards > 1 only games k with (k - 1) % nShards
+      // == shard are played, in order on one thread, and seed must be
+      // set so every shard agrees on it. With a partialPath the results
+      // so far, and the state of a game in progress, are saved there
+      // every quarter second (see Shard.h), and a run finding a
+      // matching file picks up exactly where it was saved.
+      // Early stopping is not available to shards, and a shard asked
+      // for it plays nothing.
+    int shard;
+    int nShards;
+    std::string partialPath;
+};
+
+  // Totals for one side of a tournament
+struct StrategyStats
+{
+    std::string type;
+    int wins;
+    double timeMs;
+    long calls;
+    int timeouts;
+    double cpuMs;
+    long long allocs;
+    long long allocBytes;
+    long long peakBytesSum;  // per-game peaks, for the mean
+    long long peakBytesMax;
+};
+
+struct TournamentResult
+{
+    int nGames;
+    int nUndecided;
+    double wallMs;
+    int rows;
+    int cols;
+    unsigned seed;
+    StrategyStats stats[2];
+
+      // Early stopping outcome, if sprtDelta > 0
+    bool sprt;
+    Sprt::Decision decision;
+    int decidedAt;           // games in the prefix that decided, 0 if none
+    double llr;
+    long long fixedGames;    // games a fixed-size test would need
+    int nCap;
+    std::vector<LatencyTable> latency;  // per side
+    std::vector<CalibrationTable> calibration;  // per side, for strategies that estimate hits
+
+      // Shards these results cover, if sharded
+    int nShards;
+    std::vector<int> shards;
+};
+
+TournamentResult runTournament(const TournamentConfig& config);
+void printTournament(const TournamentResult& result, std::ostream& out);
+
+  // A paired comparison: both strategies attack the same nBoards fleets
+  // with the same random numbers, and the per-board difference in shots
+  // to sink the fleet is measured. Without an opponent, board k's fleet
+  // is placed by the first strategy on odd k and the second on even k.
+struct PairedConfig
+{
+    PairedConfig(std::string type1, std::string type2, int nBoards);
+    std::string types[2];
+    std::string opponent;  // if not empty, this type places every fleet
+    int nBoards;
+    int rows;
+    int cols;
+    int nThreads;          // 0 uses every hardware thread
+    unsigned seed;         // board k is seeded from seed + k; 0 picks a seed
+    std::string outPath;   // if not empty, write one line per board here
+};
+
+struct PairedResult
+{
+    std::string types[2];
+    int nBoards;
+    int nFailed;           // boards without a fleet, or a strategy that never won
+    double wallMs;
+    unsigned seed;
+    double meanShots[2];
+    double sdShots[2];
+    double meanDiff;       // shots of the first strategy minus the second
+    double sdDiff;
+    double ciLow;          // 95% confidence interval of meanDiff
+    double ciHigh;
+    int nFewer;            // boards the first strategy sank in fewer shots
+    int nMore;
+    long long unpairedBoards;  // independent boards per strategy for the same precision
+};
+
+PairedResult runPaired(const PairedConfig& config);
+void printPaired(const PairedResult& result, std::ostream& out);
+
+#endif // TOURNAMENT_INCLUDED
@@ -0,0 +1,158 @@
+#include "Trace.h"
+#include "utility.h"
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+atomic<bool> g_tracing(false);
+
+namespace {
+
+struct TraceEvent
+{
+    const char* name;
+    long long startNs;  // steady_clock time since its epoch
+    long long durNs;
+};
+
+typedef ThreadRings<TraceEvent, 1 << 16> TraceRings;
+
+mutex g_lock;
+condition_variable g_wake;
+vector<bool> g_named;  // thread_name written, by ring id
+ofstream g_file;
+thread g_flusher;
+bool g_running = false;
+bool g_stopping = false;
+bool g_firstEvent = true;
+long long g_epochNs = 0;
+atomic<uint64_t> g_dropped(0);
+
+long long nowNs(chrono::steady_clock::time_point t)
+{
+    return chrono::duration_cast<chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+void writeSeparator()
+{
+    if (!g_firstEvent)
+        g_file << ",\n";
+    g_firstEvent = false;
+}
+
+//####################
+// Writes every buffered span to the file
+// Caller holds g_lock
+//####################
+void drainLocked()
+{
+    TraceRings::drain([](int tid, const TraceEvent& e)
+    {
+        if (static_cast<int>(g_named.size()) <= tid)
+            g_named.resize(tid + 1, false);
+        if (!g_named[tid])
+        {
+            writeSeparator();
+            g_file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+                   << ",\"args\":{\"name\":\"thread " << tid << "\"}}";
+            g_named[tid] = true;
+        }
+        writeSeparator();
+        g_file << "{\"name\":\"" << e.name << "\",\"cat\":\"game\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+               << tid << ",\"ts\":" << (e.startNs - g_epochNs) / 1000.0
+               << ",\"dur\":" << e.durNs / 1000.0 << "}";
+    });
+}
+
+void flushLoop()
+{
+    unique_lock<mutex> lock(g_lock);
+    while (!g_stopping)
+    {
+        g_wake.wait_for(lock, chrono::milliseconds(20));
+        drainLocked();
+    }
+}
+
+}  // namespace
+
+//####################
+// Appends a span to the calling thread's ring,
+// dropping it if the ring is full
+//####################
+void traceSpan(const char* name, chrono::steady_clock::time_point start,
+               chrono::steady_clock::time_point end)
+{
+    TraceEvent* e = TraceRings::reserve();
+    if (e == nullptr)
+    {
+        g_dropped.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+    long long startNs = nowNs(start);
+    *e = TraceEvent{ name, startNs, nowNs(end) - startNs };
+    TraceRings::publish();
+}
+
+//####################
+// Opens path and starts recording spans
+// Returns false if already tracing or path can't be written
+//####################
+bool startTracing(const string& path)
+{
+    if (!TRACING)
+        return false;
+
+    lock_guard<mutex> lock(g_lock);
+    if (g_running)
+        return false;
+    g_file.open(path);
+    if (!g_file)
+        return false;
+
+    // Spans that ended after the last stop are not part of this trace
+    TraceRings::discard();
+    g_named.clear();
+
+    g_file << fixed << setprecision(3) << "{\"traceEvents\":[\n";
+    g_firstEvent = true;
+    g_epochNs = nowNs(chrono::steady_clock::now());
+    g_dropped = 0;
+    g_stopping = false;
+    g_running = true;
+    g_flusher = thread(flushLoop);
+    g_tracing.store(true, memory_order_release);
+    return true;
+}
+
+//####################
+// Stops recording, writes what is buffered and closes the file
+//####################
+void stopTracing()
+{
+    {
+        lock_guard<mutex> lock(g_lock);
+        if (!g_running)
+            return;
+        g_tracing.store(false, memory_order_release);
+        g_stopping = true;
+    }
+    g_wake.notify_one();
+    g_flusher.join();
+
+    lock_guard<mutex> lock(g_lock);
+    drainLocked();
+    g_file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    g_file.close();
+    g_running = false;
+}
+
+uint64_t tracingDropped()
+{
+    return g_dropped.load(memory_order_relaxed);
+}
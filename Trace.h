@@ -0,0 +1,64 @@
+#ifndef TRACE_INCLUDED
+#define TRACE_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+  // Build with -DNO_TRACING to compile spans out
+#ifdef NO_TRACING
+const bool TRACING = false;
+#else
+const bool TRACING = true;
+#endif
+
+  // Opt-in timeline of game activity in Chrome trace-event format,
+  // viewable in chrome://tracing or ui.perfetto.dev
+  //
+  // Each thread writes spans into its own ring buffer without locking;
+  // a background thread drains the buffers into the file. A span that
+  // finds its buffer full is dropped and counted.
+bool startTracing(const std::string& path);
+void stopTracing();
+std::uint64_t tracingDropped();
+
+  // Set only between startTracing and stopTracing
+extern std::atomic<bool> g_tracing;
+
+inline bool tracing()
+{
+    return TRACING && g_tracing.load(std::memory_order_relaxed);
+}
+
+  // Appends a finished span to this thread's buffer;
+  // name must be a string literal
+void traceSpan(const char* name, std::chrono::steady_clock::time_point start,
+               std::chrono::steady_clock::time_point end);
+
+  // Traces its own lifetime as a span named name
+class TraceScope
+{
+  public:
+    explicit TraceScope(const char* name) : m_name(nullptr)
+    {
+        if (tracing())
+        {
+            m_name = name;
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+    ~TraceScope()
+    {
+        if (m_name != nullptr)
+            traceSpan(m_name, m_start, std::chrono::steady_clock::now());
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+  private:
+    const char* m_name;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+#endif // TRACE_INCLUDED
@@ -0,0 +1,273 @@
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -pthread Tune/tune.cpp Accounting.cpp Board.cpp Capture.cpp Game.cpp GameRecord.cpp Histogram.cpp OpponentModel.cpp Player.cpp ResultStore.cpp Shard.cpp Sprt.cpp Tournament.cpp Trace.cpp utility.cpp
+//
+// Usage:
+//   tune [--candidates n] [--boards n] [--validate n] [--placer type]
+//        [--threads n] [--seed s] [--out GoodTuned.h]
+//
+// Tunes GoodPlayer's constants (see GoodParams.h) by successive halving.
+// The current TUNED_GOOD_PARAMS and n random parameter sets (default 63)
+// attack the same boards, each placed by the placer strategy (default
+// good) and attacked with the same seed, so every board gives a paired
+// difference in shots to sink it. Each round scores the sets still in on
+// new boards, twice as many as the round before (starting at --boards,
+// default 50), and keeps the better half by mean difference over all
+// their boards so far, until one is left. The games of a round run at
+// once on all threads.
+//
+// The winner then meets the current values on --validate fresh boards
+// (default 4000). Only if it needs fewer shots by more than two standard
+// errors is it written to the header, as TUNED_GOOD_PARAMS; otherwise
+// the current values are written back. Rebuild to compile them in.
+
+#include "../Game.h"
+#include "../Player.h"
+#include "../Board.h"
+#include "../globals.h"
+#include "../utility.h"
+#include "../Tournament.h"
+#include "../GoodTuned.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+// Ranges searched; the hand-picked values were 2, 10 and 0
+const int MAX_LINE_WEIGHT = 8;
+const int MAX_PROXIMITY = 30;
+const int MAX_PARITY_STRIDE = 3;
+
+// Validation boards start here, clear of the tuning ones
+const unsigned VALIDATION_BOARDS = 1u << 24;
+
+struct TuneConfig
+{
+    int nCandidates = 63;
+    int nBoards = 50;
+    int nValidate = 4000;
+    string placer = "good";
+    int nThreads = 0;
+    unsigned seed = 1;
+    string outPath = "GoodTuned.h";
+};
+
+struct Candidate
+{
+    GoodParams params;
+    double sumDiff = 0;    // candidate's shots minus the current values', summed
+    double sumDiff2 = 0;
+    long long nBoards = 0;
+
+    double mean() const { return nBoards > 0 ? sumDiff / nBoards : 0; }
+};
+
+string describe(const GoodParams& p)
+{
+    return "{ " + to_string(p.lineWeight) + ", " + to_string(p.proximity) + ", " +
+           to_string(p.parityStride) + " }";
+}
+
+//######################
+// Runs job(0) .. job(nJobs - 1) on nThreads threads
+//######################
+void runParallel(int nJobs, int nThreads, function<void(int)> job)
+{
+    atomic<int> next(0);
+    auto worker = [&]()
+    {
+        for (int j = next++; j < nJobs; j = next++)
+            job(j);
+    };
+    vector<thread> threads;
+    for (int t = 0; t < nThreads; t++)
+        threads.push_back(thread(worker));
+    for (thread& t : threads)
+        t.join();
+}
+
+//######################
+// Shots a GoodPlayer with params (or the current values if
+// null) takes to sink board number board
+//
+// The placer and the attacker are seeded from the board
+// number alone, so every attacker sees the same fleet and
+// the same random numbers
+//######################
+int shotsToSink(const TuneConfig& config, const GoodParams* params, unsigned board)
+{
+    Game g(10, 10);
+    addStandardShips(g);
+    Board b(g);
+    unsigned boardSeed = config.seed * 2654435761u + board;
+    Player* placer = createPlayer(config.placer, config.placer, g);
+    seedRandom(boardSeed);
+    bool placed = placer != nullptr && placer->placeShips(b);
+    delete placer;
+    if (!placed)
+        return -1;
+
+    Player* p = params != nullptr ? createGoodPlayer("tuned", g, *params) : createPlayer("good", "good", g);
+    seedRandom(boardSeed * 2 + 1);
+    int shots = attackUntilSunk(*p, b);
+    delete p;
+    return shots;
+}
+
+//######################
+// Plays boards [first, first + n) with the current values and
+// with every candidate, adding the paired differences
+//######################
+void playBoards(const TuneConfig& config, vector<Candidate*>& alive, unsigned first, int n)
+{
+    int nSets = static_cast<int>(alive.size()) + 1;
+    vector<int> shots(static_cast<size_t>(nSets) * n);
+    runParallel(nSets * n, config.nThreads, [&](int j)
+    {
+        int set = j / n;
+        const GoodParams* params = set == 0 ? nullptr : &alive[set - 1]->params;
+        shots[j] = shotsToSink(config, params, first + j % n);
+    });
+
+    for (int k = 0; k < n; k++)
+    {
+        if (shots[k] < 0)
+            continue;
+        for (size_t c = 0; c < alive.size(); c++)
+        {
+            double diff = shots[(c + 1) * n + k] - shots[k];
+            alive[c]->sumDiff += diff;
+            alive[c]->sumDiff2 += diff * diff;
+            alive[c]->nBoards++;
+        }
+    }
+}
+
+bool writeHeader(const string& path, const GoodParams& params, const string& note)
+{
+    ofstream out(path);
+    out << "// Written by Tune/tune.cpp; rerun it rather than editing by hand" << endl
+        << "// " << note << endl
+        << endl
+        << "#ifndef GOODTUNED_INCLUDED" << endl
+        << "#define GOODTUNED_INCLUDED" << endl
+        << endl
+        << "#include \"GoodParams.h\"" << endl
+        << endl
+        << "constexpr GoodParams TUNED_GOOD_PARAMS = " << describe(params) << ";" << endl
+        << endl
+        << "#endif // GOODTUNED_INCLUDED" << endl;
+    return static_cast<bool>(out);
+}
+
+int main(int argc, char* argv[])
+{
+    TuneConfig config;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            cerr << "Missing value for " << arg << endl;
+            return 2;
+        }
+        string value = argv[++i];
+        if (arg == "--candidates")
+            config.nCandidates = max(atoi(value.c_str()), 1);
+        else if (arg == "--boards")
+            config.nBoards = max(atoi(value.c_str()), 1);
+        else if (arg == "--validate")
+            config.nValidate = max(atoi(value.c_str()), 2);
+        else if (arg == "--placer")
+            config.placer = value;
+        else if (arg == "--threads")
+            config.nThreads = atoi(value.c_str());
+        else if (arg == "--seed")
+            config.seed = strtoul(value.c_str(), nullptr, 0);
+        else if (arg == "--out")
+            config.outPath = value;
+        else
+        {
+            cerr << "Unknown argument " << arg << " " << value << endl;
+            return 2;
+        }
+    }
+    if (config.nThreads < 1)
+        config.nThreads = max<int>(thread::hardware_concurrency(), 1);
+    if (config.placer == "human")
+    {
+        cerr << "Boards can't be placed by a human player" << endl;
+        return 2;
+    }
+
+    // The current values compete too, so a round can keep them
+    mt19937 rng(config.seed);
+    vector<Candidate> candidates(config.nCandidates + 1);
+    candidates[0].params = TUNED_GOOD_PARAMS;
+    for (int c = 1; c <= config.nCandidates; c++)
+    {
+        GoodParams& p = candidates[c].params;
+        p.lineWeight = static_cast<unsigned char>(1 + rng() % MAX_LINE_WEIGHT);
+        p.proximity = static_cast<unsigned char>(1 + rng() % MAX_PROXIMITY);
+        p.parityStride = static_cast<unsigned char>(rng() % (MAX_PARITY_STRIDE + 1));
+    }
+    vector<Candidate*> alive;
+    for (Candidate& c : candidates)
+        alive.push_back(&c);
+
+    Timer timer;
+    unsigned nPlayed = 0;
+    int batch = config.nBoards;
+    while (alive.size() > 1)
+    {
+        playBoards(config, alive, nPlayed, batch);
+        nPlayed += batch;
+        stable_sort(alive.begin(), alive.end(),
+                    [](const Candidate* a, const Candidate* b) { return a->mean() < b->mean(); });
+        alive.resize((alive.size() + 1) / 2);
+        cerr << "After " << nPlayed << " boards, " << alive.size() << " left; best "
+             << describe(alive.front()->params) << " at " << showpos << fixed << setprecision(2)
+             << alive.front()->mean() << noshowpos << " shots per board" << endl;
+        batch *= 2;
+    }
+    GoodParams best = alive.front()->params;
+
+    // A fresh paired comparison, free of the selection's luck
+    Candidate check;
+    check.params = best;
+    vector<Candidate*> checked = { &check };
+    playBoards(config, checked, VALIDATION_BOARDS, config.nValidate);
+    double mean = check.mean();
+    double n = check.nBoards;
+    double var = n > 1 ? (check.sumDiff2 - n * mean * mean) / (n - 1) : 0;
+    double se = sqrt(var / max(n, 1.0));
+
+    cout << "Tuned in " << fixed << setprecision(1) << timer.elapsed() / 1000 << " s" << endl
+         << "Best " << describe(best) << ": " << showpos << setprecision(2) << mean << noshowpos
+         << " +/- " << se << " shots per board against " << describe(TUNED_GOOD_PARAMS)
+         << " over " << check.nBoards << " boards" << endl;
+
+    bool better = mean < -2 * se;
+    GoodParams chosen = better ? best : TUNED_GOOD_PARAMS;
+    ostringstream note;
+    note << "Seed " << config.seed << ", " << config.nCandidates << " candidates, boards placed by "
+         << config.placer << ": " << describe(best) << " took " << showpos << fixed << setprecision(2)
+         << mean << noshowpos << " +/- " << se << " shots per board against " << describe(TUNED_GOOD_PARAMS);
+    if (!writeHeader(config.outPath, chosen, note.str()))
+    {
+        cerr << "Cannot write " << config.outPath << endl;
+        return 1;
+    }
+    cout << (better ? "Wrote " : "No clear gain; kept ") << describe(chosen) << " in " << config.outPath << endl;
+    return 0;
+}
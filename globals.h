@@ -2,9 +2,14 @@
 #define GLOBALS_INCLUDED
 
 #include <random>
+#include <bitset>
 
 const int MAXROWS = 10;
 const int MAXCOLS = 10;
+const int MAXCELLS = MAXROWS * MAXCOLS;
+
+  // One bit per cell, indexed by r * MAXCOLS + c (16 bytes for 10x10)
+typedef std::bitset<MAXCELLS> Bitboard;
 
 enum Direction {
     HORIZONTAL, VERTICAL
@@ -19,15 +24,33 @@ class Point
     int c;
 };
 
+  // Index of a point's bit in a Bitboard
+inline int cellIndex(Point p)
+{
+    return p.r * MAXCOLS + p.c;
+}
+
+  // The calling thread's random number generator
+inline std::mt19937& randomGenerator()
+{
+    static thread_local std::random_device rd;
+    static thread_local std::mt19937 generator(rd());
+    return generator;
+}
+
+  // Make the calling thread's random numbers repeatable
+inline void seedRandom(unsigned seed)
+{
+    randomGenerator().seed(seed);
+}
+
   // Return a uniformly distributed random int from 0 to limit-1
 inline int randInt(int limit)
 {
-    static std::random_device rd;
-    static std::mt19937 generator(rd());
     if (limit < 1)
         limit = 1;
     std::uniform_int_distribution<> distro(0, limit-1);
-    return distro(generator);
+    return distro(randomGenerator());
 }
 
 #endif // GLOBALS_INCLUDED
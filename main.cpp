@@ -1,77 +1,15 @@
 #include "Game.h"
 #include "Player.h"
 #include "Board.h"
+#include "Tournament.h"
+#include "Trace.h"
+#include "Capture.h"
 #include <iostream>
 #include <iomanip>
 #include <string>
 
 using namespace std;
 
-bool addStandardShips(Game& g)
-{
-    return g.addShip(5, 'A', "aircraft carrier")  &&
-           g.addShip(4, 'B', "battleship")  &&
-           g.addShip(3, 'D', "destroyer")  &&
-           g.addShip(3, 'S', "submarine")  &&
-           g.addShip(2, 'P', "patrol boat");
-}
-
-////========================================================================
-//// Timer t;                 // create a timer and start it
-//// t.start();               // start the timer
-//// double d = t.elapsed();  // milliseconds since timer was last started
-////========================================================================
-//
-//#include <chrono>
-//
-//class Timer
-//{
-//public:
-//    Timer()
-//    {
-//        start();
-//    }
-//    void start()
-//    {
-//        m_time = std::chrono::high_resolution_clock::now();
-//    }
-//    double elapsed() const
-//    {
-//        std::chrono::duration<double, std::milli> diff =
-//            std::chrono::high_resolution_clock::now() - m_time;
-//        return diff.count();
-//    }
-//private:
-//    std::chrono::high_resolution_clock::time_point m_time;
-//};
-//
-//int main()
-//{
-//    Game g(10, 10);
-//    g.addShip(5, 'A', "aircraft carrier");
-//    g.addShip(4, 'B', "battleship");
-//    g.addShip(3, 'D', "destroyer");
-//    g.addShip(3, 'S', "submarine");
-//    g.addShip(2, 'P', "patrol boat");
-//    Board b(g);
-//    bool shotHit = false;
-//    bool destroyed = false;
-//    int id = -1;
-//    Player* p = createPlayer("good", "bob", g);
-//    p->placeShips(b);
-//    for (int i = 0; i < 100; i++)
-//    {
-//        Timer timer;
-//        timer.start();
-//        Point a = p->recommendAttack();
-//        bool valid = b.attack(a, shotHit, destroyed, id);
-//        p->recordAttackResult(a, valid, shotHit, destroyed, id);
-//        p->recordAttackByOpponent(a);
-//        cout  << timer.elapsed() << endl;
-//    }
-//    
-//}
-
 int main()
 {
     const int NTRIALS = 10;
@@ -166,11 +104,97 @@ int main()
         Game g(10, 10);
         addStandardShips(g);
         Player* p1 = createPlayer("human", name, g);
-        Player* p2 = createPlayer("good", "MEGAMIND", g);
+        Player* p2 = createPlayer("speculative", "MEGAMIND", g);
         g.play(p1, p2);
+        p2->reportStats(cout);
         delete p1;
         delete p2;
     }
+    else if (line[0] == '6')
+    {
+        int nGoodWins = 0;
+
+        for (int k = 1; k <= NTRIALS; k++)
+        {
+            cout << "============================= Salvo " << k
+                << " =============================" << endl;
+            Game g(10, 10);
+            addStandardShips(g);
+            g.setSalvo(1, true);
+            Player* p1 = createPlayer("mediocre", "Mediocre Mimi", g);
+            Player* p2 = createPlayer("good", "MEGAMIND", g);
+            Player* winner = (k % 2 == 1 ?
+                g.play(p1, p2, false) : g.play(p2, p1, false));
+            if (winner == p2)
+                nGoodWins++;
+            delete p1;
+            delete p2;
+        }
+        cout << "MEGAMIND won " << nGoodWins << " out of "
+            << NTRIALS << " salvo games." << endl;
+    }
+    else if (line[0] == '7')
+    {
+        // 5 ms per move, 200 ms per game; slow players fire at random
+        TournamentConfig config("mediocre", "good", 1000);
+        config.moveLimitMs = 5;
+        config.gameLimitMs = 200;
+        config.policy = RANDOM_MOVE;
+        printTournament(runTournament(config), cout);
+    }
+    else if (line[0] == '8')
+    {
+        // Open trace.json in chrome://tracing or ui.perfetto.dev
+        TournamentConfig config("mediocre", "good", 100);
+        config.tracePath = "trace.json";
+        printTournament(runTournament(config), cout);
+        cout << "Timeline written to trace.json";
+        if (tracingDropped() > 0)
+            cout << " (" << tracingDropped() << " spans dropped)";
+        cout << endl;
+    }
+    else if (line[0] == 'd')
+    {
+        // Load with np.load("moves.npz") in the notebook
+        TournamentConfig config("mediocre", "good", 100);
+        config.capturePath = "moves.npz";
+        printTournament(runTournament(config), cout);
+        cout << capturedMoves() << " moves captured to moves.npz";
+        if (captureDropped() > 0)
+            cout << " (" << captureDropped() << " dropped)";
+        cout << endl;
+    }
+    else if (line[0] == 'l')
+    {
+        // Each run adds to awful.bsom and good.bsom in this directory,
+        // so good needs fewer shots against awful run after run
+        TournamentConfig config("awful", "good", 1000);
+        config.modelDir = ".";
+        printTournament(runTournament(config), cout);
+    }
+    else if (line[0] == 's')
+    {
+        // Stops as soon as an SPRT separates the strategies
+        TournamentConfig config("mediocre", "good", 100000);
+        config.sprtDelta = 0.05;
+        config.batchSize = 50;
+        printTournament(runTournament(config), cout);
+    }
+    else if (line[0] == 'p')
+    {
+        // Both strategies attack the same 2000 fleets; see boards.tsv
+        PairedConfig config("mediocre", "good", 2000);
+        config.outPath = "boards.tsv";
+        printPaired(runPaired(config), cout);
+    }
+    else if (line[0] == '9')
+    {
+        // Appends to games.bsgr and results.bsrc if they already hold games
+        TournamentConfig config("mediocre", "good", 10000);
+        config.recordPath = "games.bsgr";
+        config.resultsPath = "results.bsrc";
+        printTournament(runTournament(config), cout);
+    }
     else
     {
         cout << "That's not one of the choices." << endl;
@@ -1 +1,174 @@
-#include "utility.h"
\ No newline at end of file
+#include "utility.h"
+#include <fstream>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define HAVE_MMAP
+#endif
+
+using namespace std;
+
+Fleet::Fleet() : nShips(0), totalCells(0), minAll(0), maxAll(0)
+{
+    for (int n = 0; n <= MAXLENGTH; n++)
+        lengthCount[n] = 0;
+    for (int s = 0; s < 128; s++)
+        symbolIds[s] = -1;
+}
+
+//################
+// Appends a ship type and updates aggregates
+//################
+void Fleet::add(int length, char symbol, string_view name)
+{
+    lengths.push_back(length);
+    symbols.push_back(symbol);
+    names.push_back(name);
+    symbolIds[static_cast<unsigned char>(symbol) & 0x7F] = nShips;
+    nShips++;
+
+    totalCells += length;
+    if (nShips == 1 || length < minAll)
+        minAll = length;
+    if (length > maxAll)
+        maxAll = length;
+    lengthCount[length]++;
+}
+
+//################
+// Points a ship's name at new storage
+//################
+void Fleet::rename(int shipId, string_view name)
+{
+    names[shipId] = name;
+}
+
+int Fleet::minLength(const Bitboard& alive) const
+{
+    int shortest = 0;
+    for (int id = 0; id < nShips; id++)
+        if (alive.test(id) && (shortest == 0 || lengths[id] < shortest))
+            shortest = lengths[id];
+    return shortest;
+}
+
+int Fleet::maxLength(const Bitboard& alive) const
+{
+    int longest = 0;
+    for (int id = 0; id < nShips; id++)
+        if (alive.test(id) && lengths[id] > longest)
+            longest = lengths[id];
+    return longest;
+}
+
+MappedFile::MappedFile() : m_data(nullptr), m_size(0), m_mapped(false), m_writable(false) {}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+//################
+// Maps a file read-only, or reads it into
+// memory where mmap is unavailable
+//################
+bool MappedFile::open(const string& path)
+{
+    close();
+#ifdef HAVE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED)
+        {
+            m_data = static_cast<const char*>(p);
+            m_size = st.st_size;
+            m_mapped = true;
+        }
+    }
+    ::close(fd);
+    if (m_mapped)
+        return true;
+#endif
+    ifstream in(path, ios::binary);
+    if (!in)
+        return false;
+    ostringstream contents;
+    contents << in.rdbuf();
+    m_copy = contents.str();
+    m_data = m_copy.data();
+    m_size = m_copy.size();
+    return true;
+}
+
+//################
+// Maps the first size bytes of a file for reading and
+// writing, creating or zero-extending it as needed
+// 
+// Without mmap the bytes are read into memory and
+// written back on close, so they are not shared
+//################
+bool MappedFile::openShared(const string& path, size_t size)
+{
+    close();
+    if (size == 0)
+        return false;
+#ifdef HAVE_MMAP
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && (static_cast<size_t>(st.st_size) >= size || ftruncate(fd, size) == 0))
+    {
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED)
+        {
+            m_data = static_cast<const char*>(p);
+            m_size = size;
+            m_mapped = true;
+            m_writable = true;
+        }
+    }
+    ::close(fd);
+    return m_mapped;
+#else
+    ifstream in(path, ios::binary);
+    ostringstream contents;
+    if (in)
+        contents << in.rdbuf();
+    m_copy = contents.str();
+    m_copy.resize(size < m_copy.size() ? m_copy.size() : size, '\0');
+    m_data = m_copy.data();
+    m_size = size;
+    m_writable = true;
+    m_path = path;
+    return true;
+#endif
+}
+
+void MappedFile::close()
+{
+#ifdef HAVE_MMAP
+    if (m_mapped)
+        munmap(const_cast<char*>(m_data), m_size);
+#endif
+    if (m_writable && !m_mapped)
+    {
+        ofstream out(m_path, ios::binary | ios::trunc);
+        out.write(m_copy.data(), m_copy.size());
+    }
+    m_mapped = false;
+    m_writable = false;
+    m_data = nullptr;
+    m_size = 0;
+    m_copy.clear();
+    m_path.clear();
+}
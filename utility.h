@@ -1,7 +1,15 @@
 #ifndef UTILITY_H
 #define UTILITY_H
 
+#include "globals.h"
 #include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <cstdint>
 
 // Stores ship type data
 struct ShipType
@@ -12,4 +20,229 @@ struct ShipType
     ShipType(int length, char symbol, std::string name) : length(length), symbol(symbol), name(name) {}
 };
 
-#endif
\ No newline at end of file
+// Longest ship that fits on any board
+const int MAXLENGTH = MAXROWS > MAXCOLS ? MAXROWS : MAXCOLS;
+
+// Read-only structure-of-arrays view of a game's ship types
+// 
+// Indexed by shipId; names view strings owned by the Game,
+// so a Fleet is only valid as long as its Game
+struct Fleet
+{
+    Fleet();
+    void add(int length, char symbol, std::string_view name);
+    void rename(int shipId, std::string_view name);
+
+    // Shortest and longest ship among shipIds set in alive (0 if none)
+    int minLength(const Bitboard& alive) const;
+    int maxLength(const Bitboard& alive) const;
+
+    // shipId with a symbol, or -1
+    int idOf(char symbol) const { return symbolIds[static_cast<unsigned char>(symbol) & 0x7F]; }
+
+    int nShips;
+    std::vector<int> lengths;
+    std::vector<char> symbols;
+    std::vector<std::string_view> names;
+
+    // Aggregates over all ships
+    int totalCells;
+    int minAll;
+    int maxAll;
+    int lengthCount[MAXLENGTH + 1];
+
+  private:
+    signed char symbolIds[128];
+};
+
+//========================================================================
+// Timer t;                 // create a timer and start it
+// t.start();               // start the timer
+// double d = t.elapsed();  // milliseconds since timer was last started
+//========================================================================
+class Timer
+{
+  public:
+    Timer()
+    {
+        start();
+    }
+    void start()
+    {
+        m_time = std::chrono::steady_clock::now();
+    }
+    double elapsed() const
+    {
+        std::chrono::duration<double, std::milli> diff =
+            std::chrono::steady_clock::now() - m_time;
+        return diff.count();
+    }
+  private:
+    std::chrono::steady_clock::time_point m_time;
+};
+
+//========================================================================
+// MappedFile f;            // read-only view of a whole file
+// f.open(path);            // memory-maps it (or reads it in without mmap)
+// f.data(), f.size();      // its bytes, valid until close or destruction
+// f.openShared(path, n);   // read-write view of n bytes, shared with
+//                          // other processes mapping the same file
+// f.writableData();        // its bytes, or nullptr if opened read-only
+//========================================================================
+class MappedFile
+{
+  public:
+    MappedFile();
+    ~MappedFile();
+    bool open(const std::string& path);
+    bool openShared(const std::string& path, std::size_t size);
+    void close();
+    const char* data() const { return m_data; }
+    char* writableData() { return m_writable ? const_cast<char*>(m_data) : nullptr; }
+    std::size_t size() const { return m_size; }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+  private:
+    const char* m_data;
+    std::size_t m_size;
+    bool m_mapped;        // false if read into m_copy instead
+    bool m_writable;
+    std::string m_copy;
+    std::string m_path;   // written back on close if writable and not mapped
+};
+
+//========================================================================
+// putU8(out, v);           // appends v's low byte to out
+// putU32(out, v);          // appends v to out, little-endian
+// putName(out, name);      // appends a length byte, then name cut
+//                          // to at most 255 bytes
+// getU32(p);               // the little-endian value at p
+//========================================================================
+inline void putU8(std::string& out, int v)
+{
+    out.push_back(static_cast<char>(v & 0xFF));
+}
+
+inline void putU32(std::string& out, std::uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        putU8(out, v >> (8 * i));
+}
+
+inline void putName(std::string& out, const std::string& name)
+{
+    std::size_t len = name.size() < 255 ? name.size() : 255;
+    putU8(out, static_cast<int>(len));
+    out.append(name, 0, len);
+}
+
+inline std::uint32_t getU32(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (std::uint32_t(p[3]) << 24);
+}
+
+//========================================================================
+// typedef ThreadRings<T, N> Rings;  // a ring of N items (a power of two)
+//                                   // for each thread, per item type T
+// T* slot = Rings::reserve();       // the calling thread's next free slot,
+//                                   // or nullptr if its ring is full; the
+//                                   // same slot until it is published
+// Rings::publish();                 // hands that slot to the consumer
+// Rings::drain(f);                  // calls f(ringId, item) for every
+//                                   // published item, oldest first
+// Rings::discard();                 // forgets every published item
+//
+// Each ring has one producer, its thread, and one consumer, whoever
+// drains; producers never lock. Rings are kept for the life of the
+// program and handed to new threads once their owner has exited and
+// they are drained. Ring ids count from 1 in the order rings are made.
+//========================================================================
+template <typename T, std::uint32_t N>
+class ThreadRings
+{
+  public:
+    static_assert(N > 0 && (N & (N - 1)) == 0, "ring size must be a power of two");
+
+    static T* reserve()
+    {
+        Ring& r = local();
+        std::uint32_t head = r.head.load(std::memory_order_relaxed);
+        if (head - r.tail.load(std::memory_order_acquire) >= N)
+            return nullptr;
+        return &r.items[head & (N - 1)];
+    }
+    static void publish()
+    {
+        Ring& r = local();
+        r.head.store(r.head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    template <typename F>
+    static void drain(F f)
+    {
+        std::lock_guard<std::mutex> lock(s_lock);
+        for (std::unique_ptr<Ring>& r : s_rings)
+        {
+            std::uint32_t tail = r->tail.load(std::memory_order_relaxed);
+            std::uint32_t head = r->head.load(std::memory_order_acquire);
+            for (; tail != head; tail++)
+                f(r->id, static_cast<const T&>(r->items[tail & (N - 1)]));
+            r->tail.store(head, std::memory_order_release);
+        }
+    }
+    static void discard()
+    {
+        std::lock_guard<std::mutex> lock(s_lock);
+        for (std::unique_ptr<Ring>& r : s_rings)
+            r->tail.store(r->head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+  private:
+      // The owning thread advances head, the consumer advances tail
+    struct Ring
+    {
+        T items[N];
+        std::atomic<std::uint32_t> head{0};
+        std::atomic<std::uint32_t> tail{0};
+        std::atomic<bool> released{false};  // owning thread has exited
+        int id = 0;
+    };
+    struct Owner
+    {
+        Ring* ring = nullptr;
+        ~Owner()
+        {
+            if (ring != nullptr)
+                ring->released.store(true, std::memory_order_release);
+        }
+    };
+
+    static Ring& local()
+    {
+        if (t_owner.ring == nullptr)
+            t_owner.ring = acquire();
+        return *t_owner.ring;
+    }
+
+      // Finds a drained ring whose owner has exited, or makes one
+    static Ring* acquire()
+    {
+        std::lock_guard<std::mutex> lock(s_lock);
+        for (std::unique_ptr<Ring>& r : s_rings)
+            if (r->released.load(std::memory_order_acquire) &&
+                r->head.load(std::memory_order_relaxed) == r->tail.load(std::memory_order_relaxed))
+            {
+                r->released.store(false, std::memory_order_relaxed);
+                return r.get();
+            }
+        s_rings.push_back(std::unique_ptr<Ring>(new Ring));
+        s_rings.back()->id = static_cast<int>(s_rings.size());
+        return s_rings.back().get();
+    }
+
+    inline static std::mutex s_lock;
+    inline static std::vector<std::unique_ptr<Ring>> s_rings;
+    inline static thread_local Owner t_owner;
+};
+
+#endif